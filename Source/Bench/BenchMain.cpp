@@ -0,0 +1,500 @@
+#include "../DSP/NeveTransformerDSP.h"
+#include <iostream>
+
+/**
+ * Neve Transformer - DSP microbenchmarks
+ *
+ * Measures ns/sample for each building block and the full processBlock over
+ * a grid of block sizes, sample rates and parameter states, and writes the
+ * results as JSON so runs can be diffed across commits and machines.
+ */
+
+namespace {
+
+const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+const double sampleRates[] = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+
+struct ParamState {
+  const char *name;
+  double drive, iron, hfRoll;
+  bool micMode, hiZLoad;
+  bool automate; // change iron/hfRoll every block to keep the smoothers busy
+};
+
+const ParamState paramStates[] = {
+  { "default", 0.3, 0.5, 0.7, false, true, false },
+  { "hot", 1.0, 1.0, 0.0, true, false, false },
+  { "automation", 0.3, 0.5, 0.7, false, true, true },
+};
+
+struct Measurement {
+  double nsPerSample = 0.0;    // median of the timed rounds
+  double minNsPerSample = 0.0; // best round
+  juce::int64 samples = 0;
+};
+
+// Keeps results observable so the optimiser cannot drop the work
+volatile double benchSink = 0.0;
+
+class BenchRunner {
+public:
+  explicit BenchRunner(double minSecondsPerCase) : minSeconds(minSecondsPerCase) {}
+
+  // Calls runBlock (which processes samplesPerCall samples) until each timed
+  // round has run for its share of minSeconds.
+  template <typename Fn>
+  Measurement time(int samplesPerCall, Fn &&runBlock) {
+    constexpr int numRounds = 7;
+    const double roundSeconds = minSeconds / numRounds;
+
+    // Warm-up: caches, branch predictors, smoothers settled
+    runFor(roundSeconds, runBlock);
+
+    std::vector<double> roundNs;
+    Measurement m;
+
+    for (int r = 0; r < numRounds; ++r) {
+      auto [calls, seconds] = runFor(roundSeconds, runBlock);
+      auto samples = (juce::int64)calls * samplesPerCall;
+      roundNs.push_back(seconds * 1.0e9 / (double)samples);
+      m.samples += samples;
+    }
+
+    std::sort(roundNs.begin(), roundNs.end());
+    m.nsPerSample = roundNs[roundNs.size() / 2];
+    m.minNsPerSample = roundNs.front();
+    return m;
+  }
+
+  void add(const juce::String &bench, int blockSize, double sampleRate,
+           const juce::String &state, const Measurement &m,
+           const juce::NamedValueSet &extra = {}) {
+    auto *obj = new juce::DynamicObject();
+    obj->setProperty("bench", bench);
+    obj->setProperty("blockSize", blockSize);
+    obj->setProperty("sampleRate", sampleRate);
+    obj->setProperty("state", state);
+    obj->setProperty("nsPerSample", m.nsPerSample);
+    obj->setProperty("minNsPerSample", m.minNsPerSample);
+    obj->setProperty("samples", m.samples);
+    for (const auto &property : extra)
+      obj->setProperty(property.name, property.value);
+    results.add(juce::var(obj));
+
+    std::cerr << bench << " bs=" << blockSize << " sr=" << sampleRate << " " << state
+              << ": " << juce::String(m.nsPerSample, 2) << " ns/sample";
+    for (const auto &property : extra)
+      std::cerr << " " << property.name.toString() << "=" << property.value.toString();
+    std::cerr << "\n";
+  }
+
+  juce::var toVar() const {
+    auto *machine = new juce::DynamicObject();
+    machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+    machine->setProperty("cores", juce::SystemStats::getNumCpus());
+    machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    machine->setProperty("juce", juce::SystemStats::getJUCEVersion());
+
+    auto *root = new juce::DynamicObject();
+    root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("machine", juce::var(machine));
+    root->setProperty("minSecondsPerCase", minSeconds);
+    root->setProperty("results", results);
+    return juce::var(root);
+  }
+
+private:
+  template <typename Fn>
+  std::pair<int, double> runFor(double seconds, Fn &runBlock) {
+    const auto start = juce::Time::getHighResolutionTicks();
+    const auto limit = juce::Time::secondsToHighResolutionTicks(seconds);
+    int calls = 0;
+    juce::int64 now;
+
+    do {
+      runBlock();
+      ++calls;
+      now = juce::Time::getHighResolutionTicks();
+    } while (now - start < limit);
+
+    return { calls, juce::Time::highResolutionTicksToSeconds(now - start) };
+  }
+
+  double minSeconds;
+  juce::Array<juce::var> results;
+};
+
+// Deterministic programme-like test signal at about -12 dBFS
+void fillTestSignal(double *data, int numSamples, double sampleRate, int seed) {
+  juce::Random random(seed);
+  const double w = juce::MathConstants<double>::twoPi * 220.0 / sampleRate;
+  for (int i = 0; i < numSamples; ++i)
+    data[i] = 0.2 * std::sin(w * i) + 0.05 * (random.nextDouble() * 2.0 - 1.0);
+}
+
+const char *getModeName(WaveshaperMode mode) {
+  switch (mode) {
+  case WaveshaperMode::FAST:
+    return "fast";
+  case WaveshaperMode::REFERENCE:
+    return "reference";
+  case WaveshaperMode::ADAA:
+    return "adaa";
+  }
+  return "";
+}
+
+template <typename Engine>
+void applyParams(Engine &dsp, const ParamState &state) {
+  dsp.setDrive(state.drive);
+  dsp.setIron(state.iron);
+  dsp.setHFRoll(state.hfRoll);
+  dsp.setMode(state.micMode);
+  dsp.setZLoad(state.hiZLoad);
+}
+
+void benchBiquad(BenchRunner &runner, int blockSize, double sampleRate) {
+  std::vector<double> data((size_t)blockSize);
+  fillTestSignal(data.data(), blockSize, sampleRate, 1);
+
+  BiquadFilter filter;
+  filter.setLowShelf(sampleRate, 100.0, 1.0, 0.707);
+
+  auto m = runner.time(blockSize, [&] {
+    double acc = 0.0;
+    for (int i = 0; i < blockSize; ++i)
+      acc += filter.process(data[(size_t)i]);
+    benchSink = benchSink + acc;
+  });
+  runner.add("BiquadFilter::process", blockSize, sampleRate, "lowshelf", m);
+}
+
+void benchSvfCascade(BenchRunner &runner, int blockSize, double sampleRate) {
+  using Cascade = SvfCascade<4, float>;
+  std::vector<double> data((size_t)blockSize);
+  fillTestSignal(data.data(), blockSize, sampleRate, 1);
+
+  BiquadFilter design[4];
+  design[0].setLowShelf(sampleRate, 100.0, 1.0, 0.707);
+  design[1].setHighpass(sampleRate, 20.0, 0.5);
+  design[2].setPeak(sampleRate, 12000.0, 0.5, 0.8);
+  design[3].setHighShelf(sampleRate, 12000.0, -0.5, 0.707);
+
+  Cascade cascade;
+  for (size_t s = 0; s < 4; ++s)
+    cascade.setStage(s, design[s]);
+
+  std::vector<Cascade::Vec> frames((size_t)blockSize);
+
+  // ns per frame, i.e. per sample of every float lane at once
+  auto m = runner.time(blockSize, [&] {
+    for (int i = 0; i < blockSize; ++i)
+      frames[(size_t)i] = Cascade::Vec::expand((float)data[(size_t)i]);
+    cascade.process(frames.data(), blockSize);
+    benchSink = benchSink + frames[(size_t)blockSize - 1].get(0);
+  });
+  runner.add("SvfCascade<4>::process", blockSize, sampleRate, "float", m);
+}
+
+void benchWaveshaper(BenchRunner &runner, int blockSize, double sampleRate,
+                     const ParamState &state, WaveshaperMode mode) {
+  std::vector<double> data((size_t)blockSize);
+  fillTestSignal(data.data(), blockSize, sampleRate, 2);
+  std::vector<double> coreState((size_t)blockSize);
+  for (int i = 0; i < blockSize; ++i)
+    coreState[(size_t)i] = 0.1 * (i & 7);
+  std::vector<double> work((size_t)blockSize);
+
+  Waveshaper<double> shaper;
+  shaper.setDrive(state.drive);
+  shaper.setMode(mode);
+  auto stateName = juce::String(state.name) + "/" + getModeName(mode);
+
+  auto m = runner.time(blockSize, [&] {
+    double acc = 0.0;
+    for (int i = 0; i < blockSize; ++i)
+      acc += shaper.processWithHysteresis(data[(size_t)i], coreState[(size_t)i], 0);
+    benchSink = benchSink + acc;
+  });
+  runner.add("Waveshaper::processWithHysteresis", blockSize, sampleRate, stateName, m);
+
+  auto b = runner.time(blockSize, [&] {
+    std::copy(data.begin(), data.end(), work.begin());
+    shaper.processBlock(work.data(), coreState.data(), blockSize);
+    benchSink = benchSink + work[(size_t)blockSize - 1];
+  });
+  runner.add("Waveshaper::processBlock", blockSize, sampleRate, stateName, b);
+}
+
+void benchAllpass(BenchRunner &runner, int blockSize, double sampleRate,
+                  const ParamState &state) {
+  std::vector<double> data((size_t)blockSize);
+  fillTestSignal(data.data(), blockSize, sampleRate, 3);
+
+  DynamicAllpass<double> allpass;
+  allpass.prepare(sampleRate * 4.0);
+
+  auto m = runner.time(blockSize, [&] {
+    double acc = 0.0;
+    for (int i = 0; i < blockSize; ++i)
+      acc += allpass.process(data[(size_t)i], state.drive);
+    benchSink = benchSink + acc;
+  });
+  runner.add("DynamicAllpass::process", blockSize, sampleRate, state.name, m);
+}
+
+void benchOversampler(BenchRunner &runner, int blockSize, double sampleRate) {
+  juce::AudioBuffer<double> buffer(2, blockSize);
+  for (int ch = 0; ch < 2; ++ch)
+    fillTestSignal(buffer.getWritePointer(ch), blockSize, sampleRate, 4 + ch);
+
+  Oversampler<double> oversampler;
+  oversampler.prepare(sampleRate, blockSize);
+
+  juce::dsp::AudioBlock<double> block(buffer.getArrayOfWritePointers(), 2, (size_t)blockSize);
+
+  auto up = runner.time(blockSize, [&] {
+    auto os = oversampler.upsample(block);
+    benchSink = benchSink + os.getSample(0, 0);
+  });
+  runner.add("Oversampler::upsample", blockSize, sampleRate, "4x", up);
+
+  // Downsampling reads the oversampled buffer left by the last upsample
+  auto down = runner.time(blockSize, [&] {
+    oversampler.downsample(block);
+    benchSink = benchSink + block.getSample(0, 0);
+  });
+  runner.add("Oversampler::downsample", blockSize, sampleRate, "4x", down);
+}
+
+// Engine is NeveTransformerDSP (double) or NeveTransformerDSPFloat; the
+// float engine's results carry a "/float" suffix on the state name and
+// channel counts other than stereo an "/<n>ch" suffix (ns per frame)
+template <typename Engine>
+void benchProcessBlock(BenchRunner &runner, int blockSize, double sampleRate,
+                       const ParamState &state, int numChannels = 2) {
+  juce::AudioBuffer<float> source(numChannels, blockSize);
+  juce::AudioBuffer<float> buffer(numChannels, blockSize);
+  std::vector<double> tmp((size_t)blockSize);
+  for (int ch = 0; ch < numChannels; ++ch) {
+    fillTestSignal(tmp.data(), blockSize, sampleRate, 6 + ch);
+    for (int i = 0; i < blockSize; ++i)
+      source.setSample(ch, i, (float)tmp[(size_t)i]);
+  }
+
+  Engine dsp;
+  dsp.prepare(sampleRate, blockSize, numChannels);
+  applyParams(dsp, state);
+
+  int blockCounter = 0;
+
+  auto m = runner.time(blockSize, [&] {
+    if (state.automate) {
+      const double phase = (double)(blockCounter++ % 64) / 64.0;
+      dsp.setIron(phase);
+      dsp.setHFRoll(1.0 - phase);
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+      buffer.copyFrom(ch, 0, source, ch, 0, blockSize);
+
+    dsp.processBlock(buffer);
+    benchSink = benchSink + buffer.getSample(0, blockSize - 1);
+  });
+  juce::String stateName(state.name);
+  if (std::is_same_v<Engine, NeveTransformerDSPFloat>)
+    stateName += "/float";
+  if (numChannels != 2)
+    stateName += "/" + juce::String(numChannels) + "ch";
+  runner.add("NeveTransformerDSP::processBlock", blockSize, sampleRate, stateName, m);
+}
+
+// Drives a bin-centred 5.1 kHz tone through the full chain and returns the
+// power of everything that is neither DC nor a true harmonic, relative to
+// the fundamental. Periodic steady state over the FFT frame, so no window.
+double measureAliasDb(NeveTransformerDSP &dsp, double sampleRate, int blockSize) {
+  constexpr int fftOrder = 14;
+  constexpr int fftSize = 1 << fftOrder;
+  constexpr int toneBin = 1747;
+
+  const double w = juce::MathConstants<double>::twoPi * toneBin / fftSize;
+  const int settleSamples = (int)sampleRate;
+  std::vector<float> captured((size_t)fftSize * 2);
+  juce::AudioBuffer<float> buffer(2, blockSize);
+
+  for (int pos = 0; pos < settleSamples + fftSize; pos += blockSize) {
+    for (int i = 0; i < blockSize; ++i) {
+      auto sample = (float)(0.5 * std::sin(w * (pos + i)));
+      buffer.setSample(0, i, sample);
+      buffer.setSample(1, i, sample);
+    }
+    dsp.processBlock(buffer);
+    for (int i = 0; i < blockSize; ++i) {
+      int index = pos + i - settleSamples;
+      if (index >= 0 && index < fftSize)
+        captured[(size_t)index] = buffer.getSample(0, i);
+    }
+  }
+
+  juce::dsp::FFT fft(fftOrder);
+  fft.performFrequencyOnlyForwardTransform(captured.data(), true);
+
+  double fundamental = 0.0, alias = 0.0;
+  for (int bin = 1; bin <= fftSize / 2; ++bin) {
+    double power = (double)captured[(size_t)bin] * captured[(size_t)bin];
+    if (bin == toneBin)
+      fundamental = power;
+    else if (bin % toneBin != 0)
+      alias += power;
+  }
+  return 10.0 * std::log10(juce::jmax(1.0e-30, alias) / juce::jmax(1.0e-30, fundamental));
+}
+
+// Alias level, latency and full-chain cost of each oversampling / waveshaper
+// pairing, against the 4x FIR + fast tanh default
+void benchAliasing(BenchRunner &runner, double sampleRate) {
+  using Filter = OversamplingFilter;
+  struct Config {
+    int oversampling;
+    Filter filter;
+    WaveshaperMode mode;
+  };
+  const Config configs[] = {
+    { 16, Filter::FIR, WaveshaperMode::FAST }, { 8, Filter::FIR, WaveshaperMode::FAST },
+    { 4, Filter::FIR, WaveshaperMode::FAST },  { 4, Filter::FIR, WaveshaperMode::ADAA },
+    { 4, Filter::IIR, WaveshaperMode::FAST },  { 2, Filter::FIR, WaveshaperMode::FAST },
+    { 2, Filter::FIR, WaveshaperMode::ADAA },  { 2, Filter::IIR, WaveshaperMode::ADAA },
+    { 1, Filter::FIR, WaveshaperMode::FAST },  { 1, Filter::FIR, WaveshaperMode::ADAA },
+  };
+  const auto &hot = paramStates[1];
+  const int blockSize = 512;
+
+  juce::AudioBuffer<float> source(2, blockSize);
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  std::vector<double> tmp((size_t)blockSize);
+  for (int ch = 0; ch < 2; ++ch) {
+    fillTestSignal(tmp.data(), blockSize, sampleRate, 6 + ch);
+    for (int i = 0; i < blockSize; ++i)
+      source.setSample(ch, i, (float)tmp[(size_t)i]);
+  }
+
+  for (const auto &config : configs) {
+    NeveTransformerDSP dsp;
+    dsp.setOversamplingFactor(config.oversampling);
+    dsp.setOversamplingFilter(config.filter);
+    dsp.prepare(sampleRate, blockSize);
+    applyParams(dsp, hot);
+    dsp.setWaveshaperMode(config.mode);
+
+    const double aliasDb = measureAliasDb(dsp, sampleRate, blockSize);
+
+    auto m = runner.time(blockSize, [&] {
+      for (int ch = 0; ch < 2; ++ch)
+        buffer.copyFrom(ch, 0, source, ch, 0, blockSize);
+      dsp.processBlock(buffer);
+      benchSink = benchSink + buffer.getSample(0, blockSize - 1);
+    });
+
+    juce::NamedValueSet extra;
+    extra.set("aliasDb", aliasDb);
+    extra.set("latencySamples", dsp.getLatencySamples());
+    auto name = juce::String(config.oversampling) + "x" +
+                (config.oversampling > 1 ? (config.filter == Filter::FIR ? " fir" : " iir") : "") +
+                "/" + getModeName(config.mode);
+    runner.add("Aliasing", blockSize, sampleRate, name, m, extra);
+  }
+}
+
+void printUsage() {
+  std::cout
+      << "Usage: NeveBench [options]\n"
+         "\n"
+         "  --out=<file>       Write JSON results to a file (default: stdout)\n"
+         "  --filter=<text>    Only run benchmarks whose name contains text\n"
+         "  --min-time=<sec>   Timed duration per case (default 0.05)\n"
+         "  --quick            48 kHz only, block sizes 64/512/4096\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  juce::ArgumentList args(argc, argv);
+
+  if (args.containsOption("--help|-h")) {
+    printUsage();
+    return 0;
+  }
+
+  double minTime = 0.05;
+  if (args.containsOption("--min-time"))
+    minTime = juce::jmax(0.001, args.getValueForOption("--min-time").getDoubleValue());
+
+  const juce::String filter = args.getValueForOption("--filter");
+  const bool quick = args.containsOption("--quick");
+
+  auto wanted = [&](const char *name) {
+    return filter.isEmpty() || juce::String(name).containsIgnoreCase(filter);
+  };
+
+  juce::Array<int> sizes;
+  juce::Array<double> rates;
+  for (auto bs : blockSizes)
+    if (!quick || bs == 64 || bs == 512 || bs == 4096)
+      sizes.add(bs);
+  for (auto sr : sampleRates)
+    if (!quick || sr == 48000.0)
+      rates.add(sr);
+
+  BenchRunner runner(minTime);
+
+  for (auto sampleRate : rates) {
+    for (auto blockSize : sizes) {
+      if (wanted("BiquadFilter::process"))
+        benchBiquad(runner, blockSize, sampleRate);
+      if (wanted("SvfCascade<4>::process"))
+        benchSvfCascade(runner, blockSize, sampleRate);
+
+      for (const auto &state : paramStates) {
+        if (state.automate)
+          continue;
+        if (wanted("Waveshaper::processWithHysteresis") || wanted("Waveshaper::processBlock"))
+          for (auto mode : { WaveshaperMode::FAST, WaveshaperMode::REFERENCE,
+                             WaveshaperMode::ADAA })
+            benchWaveshaper(runner, blockSize, sampleRate, state, mode);
+        if (wanted("DynamicAllpass::process"))
+          benchAllpass(runner, blockSize, sampleRate, state);
+      }
+
+      if (wanted("Oversampler::upsample") || wanted("Oversampler::downsample"))
+        benchOversampler(runner, blockSize, sampleRate);
+
+      if (wanted("NeveTransformerDSP::processBlock")) {
+        for (const auto &state : paramStates) {
+          benchProcessBlock<NeveTransformerDSP>(runner, blockSize, sampleRate, state);
+          benchProcessBlock<NeveTransformerDSPFloat>(runner, blockSize, sampleRate, state);
+        }
+        // Mono, 5.1 and 7.1.4 stems: cost should scale with channel count
+        for (int numChannels : { 1, 6, 12 })
+          benchProcessBlock<NeveTransformerDSP>(runner, blockSize, sampleRate, paramStates[0],
+                                                numChannels);
+      }
+    }
+  }
+
+  if (wanted("Aliasing"))
+    benchAliasing(runner, 48000.0);
+
+  auto json = juce::JSON::toString(runner.toVar());
+
+  if (args.containsOption("--out")) {
+    auto file = args.getFileForOption("--out");
+    if (!file.replaceWithText(json)) {
+      std::cerr << "Could not write " << file.getFullPathName() << "\n";
+      return 1;
+    }
+  } else {
+    std::cout << json << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,228 @@
+#include "../Render/BatchRenderer.h"
+#include "../Render/OfflineRenderer.h"
+#include "../UI/PresetManager.h"
+#include <iostream>
+
+/**
+ * Neve Transformer - headless renderer
+ *
+ * Renders audio files through NeveTransformerDSP without a display or audio
+ * device. Files are rendered concurrently on a thread pool. Prints one JSON
+ * object per file to stdout (samples, wall time, x-realtime factor) as each
+ * finishes, then a summary object; errors go to stderr.
+ */
+
+namespace {
+
+void printUsage() {
+  std::cout
+      << "Usage: NeveRender [options] <input files or folders...>\n"
+         "\n"
+         "  --preset=<name>    Start from a factory or user preset\n"
+         "  --drive=<0-1>      Saturation amount\n"
+         "  --iron=<0-1>       LF magnetisation\n"
+         "  --hfroll=<0-1>     HF roll-off\n"
+         "  --mix=<0-1>        Wet/dry mix\n"
+         "  --mic | --line     Transformer mode\n"
+         "  --hiz=<on|off>     Hi-Z load\n"
+         "  --bypass           Render with the DSP bypassed\n"
+         "  --shaper=<mode>    fast (default), reference (exact std::tanh) or adaa\n"
+         "  --oversampling=<n> 1, 2, 4 (default), 8 or 16; pair 1x/2x with --shaper=adaa\n"
+         "  --os-filter=<type> fir (linear phase, default) or iir (low latency)\n"
+         "  --float            Single-precision engine (default: double)\n"
+         "  --out-dir=<dir>    Output directory (default: next to each input)\n"
+         "  --block=<n>        Read/write block size, any length (default 4096)\n"
+         "  --jobs=<n>         Files rendered in parallel (default: CPU count)\n"
+         "  --segments=<n>     Split long files into up to n parallel segments; with\n"
+         "                     several jobs, each gets at most CPU count / jobs\n"
+         "  --preroll=<sec>    Segment warm-up before each boundary (default 1.0)\n"
+         "  --list-presets     Print available preset names and exit\n";
+}
+
+bool applyPreset(const juce::String &name, RenderSettings &settings) {
+  PresetManager presets;
+  auto names = presets.getPresetNames();
+
+  for (int i = 0; i < names.size(); ++i) {
+    if (names[i].startsWith("---") || !names[i].equalsIgnoreCase(name))
+      continue;
+
+    auto preset = presets.getPreset(i);
+    settings.drive = preset.drive;
+    settings.iron = preset.iron;
+    settings.hfRoll = preset.hfRoll;
+    settings.mix = preset.mix;
+    settings.micMode = preset.micMode;
+    settings.hiZLoad = preset.hiZLoad;
+    return true;
+  }
+  return false;
+}
+
+double getUnitOption(const juce::ArgumentList &args, const juce::String &option,
+                     double fallback) {
+  if (!args.containsOption(option))
+    return fallback;
+  return juce::jlimit(0.0, 1.0, args.getValueForOption(option).getDoubleValue());
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  juce::ArgumentList args(argc, argv);
+
+  if (args.size() == 0 || args.containsOption("--help|-h")) {
+    printUsage();
+    return 0;
+  }
+
+  if (args.containsOption("--list-presets")) {
+    PresetManager presets;
+    for (const auto &name : presets.getPresetNames())
+      if (!name.startsWith("---"))
+        std::cout << name << "\n";
+    return 0;
+  }
+
+  RenderSettings settings;
+
+  if (args.containsOption("--preset")) {
+    auto presetName = args.getValueForOption("--preset");
+    if (!applyPreset(presetName, settings)) {
+      std::cerr << "Unknown preset: " << presetName << "\n";
+      return 1;
+    }
+  }
+
+  settings.drive = getUnitOption(args, "--drive", settings.drive);
+  settings.iron = getUnitOption(args, "--iron", settings.iron);
+  settings.hfRoll = getUnitOption(args, "--hfroll", settings.hfRoll);
+  settings.mix = (float)getUnitOption(args, "--mix", settings.mix);
+
+  if (args.containsOption("--mic"))
+    settings.micMode = true;
+  if (args.containsOption("--line"))
+    settings.micMode = false;
+  if (args.containsOption("--hiz"))
+    settings.hiZLoad = args.getValueForOption("--hiz").equalsIgnoreCase("on");
+  if (args.containsOption("--bypass"))
+    settings.bypassed = true;
+  if (args.containsOption("--shaper")) {
+    auto shaper = args.getValueForOption("--shaper");
+    if (shaper.equalsIgnoreCase("reference"))
+      settings.shaperMode = WaveshaperMode::REFERENCE;
+    else if (shaper.equalsIgnoreCase("adaa"))
+      settings.shaperMode = WaveshaperMode::ADAA;
+    else
+      settings.shaperMode = WaveshaperMode::FAST;
+  }
+  if (args.containsOption("--oversampling"))
+    settings.oversampling = args.getValueForOption("--oversampling").getIntValue();
+  if (args.containsOption("--os-filter"))
+    settings.oversamplingFilter = args.getValueForOption("--os-filter").equalsIgnoreCase("iir")
+                                      ? OversamplingFilter::IIR
+                                      : OversamplingFilter::FIR;
+  if (args.containsOption("--float"))
+    settings.doublePrecision = false;
+  if (args.containsOption("--block"))
+    settings.blockSize = juce::jmax(16, args.getValueForOption("--block").getIntValue());
+
+  juce::File outDir;
+  if (args.containsOption("--out-dir")) {
+    outDir = args.getFileForOption("--out-dir");
+    outDir.createDirectory();
+  }
+
+  if (args.containsOption("--segments"))
+    settings.maxSegments = juce::jmax(1, args.getValueForOption("--segments").getIntValue());
+  if (args.containsOption("--preroll"))
+    settings.preRollSeconds = juce::jmax(0.0, args.getValueForOption("--preroll").getDoubleValue());
+
+  int numJobs = juce::SystemStats::getNumCpus();
+  if (args.containsOption("--jobs"))
+    numJobs = juce::jmax(1, args.getValueForOption("--jobs").getIntValue());
+
+  // Inputs that can't be rendered count as failed files
+  int rejected = 0;
+
+  juce::Array<juce::File> inputs;
+  for (const auto &arg : args.arguments) {
+    if (arg.isOption())
+      continue;
+    auto file = arg.resolveAsFile();
+    if (!file.exists()) {
+      std::cerr << "Not found: " << file.getFullPathName() << "\n";
+      ++rejected;
+    }
+    inputs.add(file);
+  }
+
+  inputs = BatchRenderer::collectAudioFiles(inputs);
+
+  if (inputs.isEmpty()) {
+    printUsage();
+    return 1;
+  }
+
+  juce::AudioFormatManager formatManager;
+  formatManager.registerBasicFormats();
+
+  // Jobs run concurrently, so two of them must never write the same file
+  // or overwrite an input
+  juce::Array<BatchRenderer::Item> items;
+  for (const auto &input : inputs) {
+    auto dir = outDir == juce::File() ? input.getParentDirectory() : outDir;
+    auto output = dir.getChildFile(input.getFileNameWithoutExtension() +
+                                   BatchRenderer::outputSuffix +
+                                   OfflineRenderer::getOutputExtensionFor(input));
+    bool collides = inputs.contains(output);
+    for (const auto &item : items)
+      collides = collides || item.output == output;
+    if (collides) {
+      std::cerr << input.getFullPathName() << ": output " << output.getFullPathName()
+                << " is already an input or another file's output\n";
+      ++rejected;
+      continue;
+    }
+    items.add({ input, output });
+  }
+
+  if (items.isEmpty())
+    return 1;
+
+  juce::CriticalSection outputLock;
+  std::atomic<int> failures { rejected };
+
+  // Every job can start its own segment threads: share the CPUs between
+  // them rather than running jobs x segments render threads
+  numJobs = juce::jmin(numJobs, items.size());
+  if (numJobs > 1)
+    settings.maxSegments =
+        juce::jmin(settings.maxSegments, juce::jmax(1, juce::SystemStats::getNumCpus() / numJobs));
+
+  BatchRenderer batch(formatManager, numJobs);
+  batch.onJobFinished = [&](const RenderResult &result) {
+    const juce::ScopedLock sl(outputLock);
+    std::cout << result.toJSON() << std::endl;
+
+    if (!result.succeeded) {
+      std::cerr << result.inputFile.getFullPathName() << ": " << result.error << "\n";
+      ++failures;
+    }
+  };
+
+  batch.start(items, settings);
+  batch.waitForCompletion();
+
+  auto *summary = new juce::DynamicObject();
+  summary->setProperty("summary", true);
+  summary->setProperty("files", batch.getNumJobs() + rejected);
+  summary->setProperty("failed", failures.load());
+  summary->setProperty("threads", batch.getNumThreads());
+  summary->setProperty("audioSeconds", batch.getRenderedAudioSeconds());
+  summary->setProperty("wallSeconds", batch.getElapsedSeconds());
+  summary->setProperty("xRealtime", batch.getRealtimeFactor());
+  std::cout << juce::JSON::toString(juce::var(summary), true) << std::endl;
+
+  return failures.load() == 0 ? 0 : 1;
+}
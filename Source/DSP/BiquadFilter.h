@@ -6,9 +6,22 @@
 
 /**
  * High-precision biquad filter for transformer emulation
+ * Each design is also expressed as a trapezoidal state-variable filter
+ * (same response), which stays accurate at low frequencies in float.
  */
 class BiquadFilter {
 public:
+  struct Coefficients {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0;
+    double a1 = 0.0, a2 = 0.0;
+  };
+
+  // y = m0 * input + m1 * band + m2 * low, with g = tan(pi fc / fs), k = 1 / Q
+  struct SvfCoefficients {
+    double g = 0.0, k = 2.0;
+    double m0 = 1.0, m1 = 0.0, m2 = 0.0;
+  };
+
   BiquadFilter() { reset(); }
 
   void reset() { z1 = z2 = 0.0; }
@@ -23,6 +36,9 @@ public:
     return output;
   }
 
+  Coefficients getCoefficients() const { return { b0, b1, b2, a1, a2 }; }
+  SvfCoefficients getSvfCoefficients() const { return svf; }
+
   void setLowpass(double sampleRate, double fc, double Q) {
     double w0 = juce::MathConstants<double>::twoPi * fc / sampleRate;
     double alpha = std::sin(w0) / (2.0 * Q);
@@ -34,6 +50,8 @@ public:
     b2 = ((1.0 - cosw0) / 2.0) / a0;
     a1 = (-2.0 * cosw0) / a0;
     a2 = (1.0 - alpha) / a0;
+
+    svf = { prewarp(sampleRate, fc), 1.0 / Q, 0.0, 0.0, 1.0 };
   }
 
   void setHighpass(double sampleRate, double fc, double Q) {
@@ -47,6 +65,8 @@ public:
     b2 = ((1.0 + cosw0) / 2.0) / a0;
     a1 = (-2.0 * cosw0) / a0;
     a2 = (1.0 - alpha) / a0;
+
+    svf = { prewarp(sampleRate, fc), 1.0 / Q, 1.0, -1.0 / Q, -1.0 };
   }
 
   void setPeak(double sampleRate, double fc, double gainDB, double Q) {
@@ -61,6 +81,9 @@ public:
     b2 = (1.0 - alpha * A) / a0;
     a1 = (-2.0 * cosw0) / a0;
     a2 = (1.0 - alpha / A) / a0;
+
+    double k = 1.0 / (Q * A);
+    svf = { prewarp(sampleRate, fc), k, 1.0, k * (A * A - 1.0), 0.0 };
   }
 
   void setLowShelf(double sampleRate, double fc, double gainDB, double Q = 0.707) {
@@ -76,6 +99,8 @@ public:
     b2 = (A * ((A + 1.0) - (A - 1.0) * cosw0 - sqrtA2alpha)) / a0;
     a1 = (-2.0 * ((A - 1.0) + (A + 1.0) * cosw0)) / a0;
     a2 = ((A + 1.0) + (A - 1.0) * cosw0 - sqrtA2alpha) / a0;
+
+    svf = { prewarp(sampleRate, fc) / std::sqrt(A), 1.0 / Q, 1.0, (A - 1.0) / Q, A * A - 1.0 };
   }
 
   void setHighShelf(double sampleRate, double fc, double gainDB, double Q = 0.707) {
@@ -91,10 +116,18 @@ public:
     b2 = (A * ((A + 1.0) - (A - 1.0) * cosw0 - sqrtA2alpha)) / a0;
     a1 = (2.0 * ((A - 1.0) - (A + 1.0) * cosw0)) / a0;
     a2 = ((A + 1.0) - (A - 1.0) * cosw0 - sqrtA2alpha) / a0;
+
+    svf = { prewarp(sampleRate, fc) * std::sqrt(A), 1.0 / Q, A * A, A * (1.0 - A) / Q,
+            1.0 - A * A };
   }
 
 private:
+  static double prewarp(double sampleRate, double fc) {
+    return std::tan(juce::MathConstants<double>::pi * fc / sampleRate);
+  }
+
   double z1 = 0.0, z2 = 0.0;
   double b0 = 1.0, b1 = 0.0, b2 = 0.0;
   double a1 = 0.0, a2 = 0.0;
+  SvfCoefficients svf;
 };
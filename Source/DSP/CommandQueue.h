@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Waveshaper.h"
+#include <juce_core/juce_core.h>
+#include <array>
+
+/** The user-facing parameter set, applied as one unit (presets, A/B) */
+struct EngineParameters {
+  double drive = 0.3;
+  double iron = 0.5;
+  double hfRoll = 0.7;
+  bool micMode = false;
+  bool hiZLoad = true;
+  double mix = 1.0;
+};
+
+/**
+ * One change for the audio thread, applied at the first control-grid
+ * boundary at or after sampleTime (stream samples since prepare/reset;
+ * negative = next boundary)
+ */
+struct EngineCommand {
+  enum class Type {
+    DRIVE,
+    IRON,
+    HF_ROLL,
+    MIC_MODE,
+    HI_Z_LOAD,
+    BYPASS,
+    SHAPER_MODE,
+    PARAMETERS,
+    LOW_LATENCY,
+    MIX
+  };
+
+  Type type = Type::DRIVE;
+  juce::int64 sampleTime = -1;
+  double value = 0.0;           // scalar types; switches use value != 0
+  WaveshaperMode shaperMode {}; // SHAPER_MODE
+  EngineParameters parameters;  // PARAMETERS
+};
+
+/**
+ * Single-producer/single-consumer FIFO over a fixed array (juce::AbstractFifo
+ * indices): one thread pushes, the audio thread peeks and pops. Never locks
+ * or allocates.
+ */
+template <typename Item, int Capacity>
+class SpscQueue {
+public:
+  /** False when full; the item is dropped */
+  bool push(const Item &item) {
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0)
+      return false;
+    items[(size_t)(size1 > 0 ? start1 : start2)] = item;
+    fifo.finishedWrite(1);
+    return true;
+  }
+
+  /** Oldest item, or nullptr when empty; it stays queued until pop() */
+  const Item *peek() const {
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    if (size1 + size2 == 0)
+      return nullptr;
+    return &items[(size_t)(size1 > 0 ? start1 : start2)];
+  }
+
+  void pop() { fifo.finishedRead(1); }
+
+private:
+  juce::AbstractFifo fifo { Capacity };
+  std::array<Item, (size_t)Capacity> items {};
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "StateArchive.h"
 #include <cmath>
 #include <juce_audio_basics/juce_audio_basics.h>
 
@@ -7,54 +8,68 @@
  * Dynamic allpass filter for AM/PM simulation
  * Level-dependent phase shift: +3° @ +6dBu, +10° @ +12dBu
  */
+template <typename SampleType>
 class DynamicAllpass {
 public:
   DynamicAllpass() { reset(); }
 
-  void reset() { z1 = 0.0; }
+  void reset() { z1 = SampleType(0.0); }
 
   void prepare(double sampleRate) {
     // Envelope follower time constants
-    attackCoeff = std::exp(-1.0 / (sampleRate * 0.005));  // 5ms attack
-    releaseCoeff = std::exp(-1.0 / (sampleRate * 0.020)); // 20ms release
-    coreStateCoeff =
-        std::exp(-1.0 / (sampleRate * 0.020)); // 20ms for hysteresis
+    attackCoeff = static_cast<SampleType>(std::exp(-1.0 / (sampleRate * 0.005)));  // 5ms attack
+    releaseCoeff = static_cast<SampleType>(std::exp(-1.0 / (sampleRate * 0.020))); // 20ms release
+    coreStateCoeff = static_cast<SampleType>(
+        std::exp(-1.0 / (sampleRate * 0.020))); // 20ms for hysteresis
   }
 
-  inline double process(double input, double drive) {
+  inline SampleType process(SampleType input, SampleType drive) {
+    const SampleType one(1.0);
+
     // Envelope follower
-    double inputAbs = std::abs(input);
+    SampleType inputAbs = std::abs(input);
     if (inputAbs > envelope)
-      envelope = attackCoeff * envelope + (1.0 - attackCoeff) * inputAbs;
+      envelope = attackCoeff * envelope + (one - attackCoeff) * inputAbs;
     else
-      envelope = releaseCoeff * envelope + (1.0 - releaseCoeff) * inputAbs;
+      envelope = releaseCoeff * envelope + (one - releaseCoeff) * inputAbs;
 
     // Update core state (slow magnetization memory)
-    coreState = coreStateCoeff * coreState + (1.0 - coreStateCoeff) * envelope;
+    coreState = coreStateCoeff * coreState + (one - coreStateCoeff) * envelope;
 
     // Clamp envelope to prevent instability on hot signals
-    double clampedEnv = juce::jmin(envelope, 1.0);
+    SampleType clampedEnv = juce::jmin(envelope, one);
 
     // Allpass depth: 0-0.3 radians based on level and drive
     // 0.3 radians ~ 17 degrees, scaled by envelope and drive
-    double depth = 0.3 * clampedEnv * drive;
-    double a = std::tanh(depth); // Clamp to stable range
+    SampleType depth = SampleType(0.3) * clampedEnv * drive;
+    SampleType a = std::tanh(depth); // Clamp to stable range
 
     // First-order allpass: H(z) = (a + z^-1) / (1 + a*z^-1)
-    double output = -a * input + z1;
+    SampleType output = -a * input + z1;
     z1 = input + a * output;
 
     return output;
   }
 
-  double getCoreState() const { return coreState; }
+  SampleType getCoreState() const { return coreState; }
+
+  void transferState(StateArchive &archive) {
+    archive.value(z1);
+    archive.value(envelope);
+    archive.value(coreState);
+  }
+
+  /** True when the allpass, envelope and core memory have all decayed below threshold */
+  bool isQuiet(SampleType threshold) const {
+    return std::abs(z1) < threshold && envelope < threshold && coreState < threshold;
+  }
 
 private:
-  double z1 = 0.0;
-  double envelope = 0.0;
-  double coreState = 0.0;
+  SampleType z1 = SampleType(0.0);
+  SampleType envelope = SampleType(0.0);
+  SampleType coreState = SampleType(0.0);
 
-  double attackCoeff = 0.99;
-  double releaseCoeff = 0.995;
-  double coreStateCoeff = 0.995;
+  SampleType attackCoeff = SampleType(0.99);
+  SampleType releaseCoeff = SampleType(0.995);
+  SampleType coreStateCoeff = SampleType(0.995);
 };
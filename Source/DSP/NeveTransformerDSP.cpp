@@ -1,215 +1,872 @@
 #include "NeveTransformerDSP.h"
 
-NeveTransformerDSP::NeveTransformerDSP() {}
+namespace {
+
+// Soft limit to prevent DAC clipping
+template <typename SampleType>
+inline SampleType softLimit(SampleType sample) {
+  const SampleType one(1.0);
+  if (sample > one)
+    return one - std::exp(-(sample - one));
+  if (sample < -one)
+    return -(one - std::exp(-(-sample - one)));
+  return sample;
+}
 
-void NeveTransformerDSP::prepare(double newSampleRate, int maxBlockSize) {
-  sampleRate = newSampleRate;
-  maxPreparedBlockSize = maxBlockSize;
+// Packs count channels, from sample offset on, into SIMD frames, one channel
+// per lane; unused lanes are zeroed so a group that shrinks never carries
+// stale audio
+template <typename SampleType, typename InputType>
+void interleave(SampleType *frames, const InputType *const *channels, int count, int offset,
+                int numSamples) {
+  constexpr size_t numLanes = juce::dsp::SIMDRegister<SampleType>::SIMDNumElements;
+  for (size_t lane = 0; lane < numLanes; ++lane) {
+    SampleType *dest = frames + lane;
+    if ((int)lane < count) {
+      const InputType *src = channels[lane] + offset;
+      for (int i = 0; i < numSamples; ++i)
+        dest[(size_t)i * numLanes] = static_cast<SampleType>(src[i]);
+    } else {
+      for (int i = 0; i < numSamples; ++i)
+        dest[(size_t)i * numLanes] = SampleType(0.0);
+    }
+  }
+}
 
-  // Prepare oversampler (4x = 192 kHz for 48 kHz input)
-  oversampler.prepare(sampleRate, maxBlockSize);
+template <typename SampleType>
+void deinterleave(SampleType *const *channels, const SampleType *frames, int count,
+                  int numSamples) {
+  constexpr size_t numLanes = juce::dsp::SIMDRegister<SampleType>::SIMDNumElements;
+  for (int lane = 0; lane < count; ++lane) {
+    SampleType *dest = channels[lane];
+    for (int i = 0; i < numSamples; ++i)
+      dest[i] = frames[(size_t)i * numLanes + (size_t)lane];
+  }
+}
 
-  // Allocate double buffer
-  doubleBuffer.setSize(2, maxBlockSize);
+// Leading samples that are digital silence in every channel
+int countLeadingSilence(const juce::AudioBuffer<float> &buffer, int start, int numSamples,
+                        int numChannels) {
+  int silent = numSamples;
+  for (int ch = 0; ch < numChannels; ++ch) {
+    const float *data = buffer.getReadPointer(ch, start);
+    int i = 0;
+    while (i < silent && data[i] == 0.0f)
+      ++i;
+    silent = i;
+  }
+  return silent;
+}
 
-  // Prepare dynamic components
-  for (int ch = 0; ch < 2; ++ch) {
-    allpass[ch].prepare(sampleRate * 4.0); // Oversampled rate
-    waveshaper[ch].setDrive(driveParam.getTargetValue());
+// Offset of the last sample that isn't digital silence in some channel, or -1
+int findLastSound(const juce::AudioBuffer<float> &buffer, int start, int numSamples,
+                  int numChannels) {
+  int last = -1;
+  for (int ch = 0; ch < numChannels; ++ch) {
+    const float *data = buffer.getReadPointer(ch, start);
+    for (int i = numSamples - 1; i > last; --i)
+      if (data[i] != 0.0f) {
+        last = i;
+        break;
+      }
   }
+  return last;
+}
+
+EngineCommand makeCommand(EngineCommand::Type type, double value, juce::int64 sampleTime) {
+  EngineCommand command;
+  command.type = type;
+  command.value = value;
+  command.sampleTime = sampleTime;
+  return command;
+}
+
+} // namespace
 
-  // Prepare smoothed params (0.05s ramp)
+template <typename SampleType>
+NeveTransformerEngine<SampleType>::NeveTransformerEngine() {}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::prepare(double newSampleRate, int maxBlockSize,
+                                                int newNumChannels) {
+  sampleRate = newSampleRate;
+  maxPreparedBlockSize = maxBlockSize;
+  numChannels = juce::jmax(1, newNumChannels);
+  const size_t numGroups = ((size_t)numChannels + numLanes - 1) / numLanes;
+
+  // Audio is stopped: apply everything queued so far, whatever its timestamp
+  for (int i = 0; i < numPendingCommands; ++i)
+    applyCommand(pendingCommands[(size_t)i]);
+  numPendingCommands = 0;
+  while (auto *command = commands.peek()) {
+    applyCommand(*command);
+    commands.pop();
+  }
+
+  // Prepare oversampler (4x = 192 kHz for 48 kHz input by default)
+  oversampler.setHistoryEnabled(stateCaptureEnabled);
+  oversampler.prepare(sampleRate, maxBlockSize, numChannels);
+  oversampler.setLowLatency(lowLatency);
+  const double oversampledRate = sampleRate * oversampler.getFactor();
+
+  // Allocate work buffers and interleaved SIMD frames (reused per group)
+  workBuffer.setSize(numChannels, maxBlockSize);
+  frameBuffer.assign((size_t)maxBlockSize, FilterVec::expand(SampleType(0.0)));
+  driveValues.assign((size_t)maxBlockSize, 0.0);
+  mixValues.assign((size_t)maxBlockSize, 1.0f);
+  const int dryDelaySize = juce::nextPowerOfTwo(oversampler.getMaxLatencySamples() + maxBlockSize);
+  dryDelay.setSize(numChannels, dryDelaySize);
+  dryDelayMask = dryDelaySize - 1;
+  inputLevels.assign((size_t)numChannels, 0.0f);
+  outputLevels.assign((size_t)numChannels, 0.0f);
+  controlPoints.resize((size_t)(maxBlockSize / controlInterval + 2));
+  preFilters.resize(numGroups);
+  postFilters.resize(numGroups);
+  waveshaper.resize((size_t)numChannels);
+  allpass.resize((size_t)numChannels);
+
+  // Prepare smoothed params (0.05s ramp), starting at the current targets
   driveParam.reset(sampleRate, 0.05);
   ironParam.reset(sampleRate, 0.05);
   hfRollParam.reset(sampleRate, 0.05);
+  mixParam.reset(sampleRate, 0.05);
+
+  // Prepare dynamic components
+  for (int ch = 0; ch < numChannels; ++ch) {
+    allpass[(size_t)ch].prepare(oversampledRate);
+    waveshaper[(size_t)ch].setDrive(driveParam.getTargetValue());
+    waveshaper[(size_t)ch].setMode(shaperMode);
+  }
 
-  filtersDirty.store(true, std::memory_order_release);
+  // Long enough for the oversampler's delay line to carry nothing but silence
+  minSilentSamples = idleSleepEnabled ? oversampler.getMaxLatencySamples() + sleepCheckInterval
+                                      : std::numeric_limits<int>::max();
+
+  buildCoefficientTables();
   reset();
-}
 
-void NeveTransformerDSP::reset() {
-  for (int ch = 0; ch < 2; ++ch) {
-    lfPoleFilter[ch].reset();
-    hfResonanceFilter[ch].reset();
-    ironFilter[ch].reset();
-    hfRollFilter[ch].reset();
-    postShelfFilter[ch].reset();
-    dcBlocker[ch].reset();
-    allpass[ch].reset();
-    waveshaper[ch].reset();
+  stateSize = 0;
+  if (stateCaptureEnabled) {
+    auto measure = StateArchive::measure();
+    transferState(measure);
+    stateSize = measure.getPosition();
   }
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::reset() {
+  resetState();
+  controlPhase = 0;
+  boundaryUpdated = false;
+  samplePosition = 0;
+  publishedPosition.store(0, std::memory_order_release);
+  silentRun = 0;
+  outputPeak = 0.0f;
+  sleeping = false;
+  dryDelay.clear();
+  dryWritten = 0;
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::resetState() {
+  for (auto &cascade : preFilters)
+    cascade.reset();
+  for (auto &cascade : postFilters)
+    cascade.reset();
+  for (auto &stage : allpass)
+    stage.reset();
+  for (auto &stage : waveshaper)
+    stage.reset();
   oversampler.reset();
 }
 
-void NeveTransformerDSP::updateFilters() {
-  double lfCutoff = micMode.load(std::memory_order_relaxed) ? 50.0 : 60.0;
-  double lfQ = 0.7;
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::saveState(void *data, size_t size) {
+  if (stateSize == 0 || size < stateSize)
+    return false;
+  auto archive = StateArchive::save(data, size);
+  return transferState(archive);
+}
 
-  double hfPeakFreq = 14000.0;
-  double hfPeakGain = 1.5;
-  double hfPeakQ = 1.2;
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::restoreState(const void *data, size_t size) {
+  if (stateSize == 0 || size < stateSize)
+    return false;
+  auto archive = StateArchive::restore(data, size);
+  return transferState(archive);
+}
 
-  double hfRollFreq = 20000.0 + hfRollParam.getCurrentValue() * 10000.0;
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::transferState(StateArchive &archive) {
+  // Layout first, so a mismatched blob is rejected before anything changes
+  juce::uint32 tag = stateTag;
+  int sampleBytes = (int)sizeof(SampleType), channels = numChannels;
+  int factor = oversampler.getFactor();
+  auto filterType = oversampler.getFilterType();
+  double rate = sampleRate;
+  archive.value(tag);
+  archive.value(sampleBytes);
+  archive.value(channels);
+  archive.value(factor);
+  archive.value(filterType);
+  archive.value(rate);
+  if (!archive.isValid() || tag != stateTag || sampleBytes != (int)sizeof(SampleType) ||
+      channels != numChannels || factor != oversampler.getFactor() ||
+      filterType != oversampler.getFilterType() || rate != sampleRate)
+    return false;
+
+  archive.value(samplePosition);
+  archive.value(controlPhase);
+  archive.value(boundaryUpdated);
+  for (auto *param : { &driveParam, &ironParam, &hfRollParam, &mixParam })
+    param->transferState(archive);
+  archive.value(micMode);
+  archive.value(highZLoad);
+  archive.value(bypassed);
+  archive.value(lowLatency);
+  archive.value(shaperMode);
+  archive.value(designedMicMode);
+  archive.value(designedHighZLoad);
+  archive.value(silentRun);
+  archive.value(outputPeak);
+  archive.value(sleeping);
+
+  for (auto &cascade : preFilters)
+    cascade.transferState(archive);
+  for (auto &cascade : postFilters)
+    cascade.transferState(archive);
+  for (int ch = 0; ch < numChannels; ++ch) {
+    waveshaper[(size_t)ch].transferState(archive);
+    allpass[(size_t)ch].transferState(archive);
+  }
+  oversampler.transferState(archive);
+
+  // The dry input the delay line can still be asked for, oldest first
+  const int dryLength = oversampler.getMaxLatencySamples();
+  const int ringStart = (int)((samplePosition - dryLength) & dryDelayMask);
+  const int firstPart = juce::jmin(dryLength, dryDelay.getNumSamples() - ringStart);
+  if (archive.isRestoring())
+    dryDelay.clear();
+  for (int ch = 0; ch < numChannels; ++ch) {
+    archive.items(dryDelay.getWritePointer(ch, ringStart), (size_t)firstPart);
+    archive.items(dryDelay.getWritePointer(ch), (size_t)(dryLength - firstPart));
+  }
 
-  double maxFreq = sampleRate * 0.48;
-  hfRollFreq = juce::jmin(hfRollFreq, maxFreq);
-  hfPeakFreq = juce::jmin(hfPeakFreq, maxFreq);
+  if (archive.isRestoring()) {
+    dryWritten = samplePosition;
+    publishedPosition.store(samplePosition, std::memory_order_release);
+  }
+  return archive.isValid();
+}
 
-  double ironGain = ironParam.getCurrentValue() * 2.0;
-  double postThickGain = 0.2;
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::isQuiet() const {
+  const auto threshold = static_cast<SampleType>(sleepThreshold);
+  for (const auto &cascade : preFilters)
+    if (!cascade.isQuiet(threshold))
+      return false;
+  for (const auto &cascade : postFilters)
+    if (!cascade.isQuiet(threshold))
+      return false;
+  for (const auto &stage : allpass)
+    if (!stage.isQuiet(threshold))
+      return false;
+  return true;
+}
 
-  if (!highZLoad.load(std::memory_order_relaxed))
-    hfPeakQ = 0.8;
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::designIron(BiquadFilter &filter, double iron) const {
+  filter.setLowShelf(sampleRate, 100.0, iron * 2.0, 0.707);
+}
 
-  for (int ch = 0; ch < 2; ++ch) {
-    lfPoleFilter[ch].setHighpass(sampleRate, lfCutoff, lfQ);
-    hfResonanceFilter[ch].setPeak(sampleRate, hfPeakFreq, hfPeakGain, hfPeakQ);
-    ironFilter[ch].setLowShelf(sampleRate, 100.0, ironGain, 0.707);
-    hfRollFilter[ch].setLowpass(sampleRate, hfRollFreq, 0.707);
-    postShelfFilter[ch].setLowShelf(sampleRate, 80.0, postThickGain, 0.707);
-    dcBlocker[ch].setHighpass(sampleRate, 5.0, 0.707);
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::designHFRoll(BiquadFilter &filter, double hfRoll) const {
+  filter.setLowpass(sampleRate, juce::jmin(20000.0 + hfRoll * 10000.0, sampleRate * 0.48), 0.707);
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::buildCoefficientTables() {
+  const double rate = sampleRate;
+  const double maxFreq = rate * 0.48;
+
+  ironTable.build([this](BiquadFilter &filter, double iron) { designIron(filter, iron); });
+  // HF roll (20-30 kHz) is tabulated over its range below the 0.48 fs clamp,
+  // so no interpolation interval straddles the kink
+  const double hfRollSpan = juce::jlimit(0.0, 10000.0, maxFreq - 20000.0);
+  hfRollTableScale = hfRollSpan > 0.0 ? 10000.0 / hfRollSpan : 0.0;
+  hfRollTable.build([this, hfRollSpan](BiquadFilter &filter, double position) {
+    designHFRoll(filter, position * hfRollSpan / 10000.0);
+  });
+
+  postShelfFilter.setLowShelf(rate, 80.0, 0.2, 0.707);
+  dcBlocker.setHighpass(rate, 5.0, 0.707);
+
+  ControlPoint initial;
+  designIron(ironFilter, ironParam.getCurrentValue());
+  designHFRoll(hfRollFilter, hfRollParam.getCurrentValue());
+  initial.stages[0] = ironFilter.getSvfCoefficients();
+  initial.stages[3] = hfRollFilter.getSvfCoefficients();
+  initial.changedStages = 0x1 | 0x8;
+  updateSwitchedFilters(initial, true);
+  for (auto &cascade : preFilters)
+    applyControlPoint(cascade, initial);
+  for (auto &cascade : postFilters) {
+    cascade.setStage(0, postShelfFilter);
+    cascade.setStage(1, dcBlocker);
   }
 }
 
-void NeveTransformerDSP::processBlock(juce::AudioBuffer<float> &buffer) {
-  if (bypassed.load(std::memory_order_relaxed))
-    return;
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::updateSwitchedFilters(ControlPoint &point, bool force) {
+  const double maxFreq = sampleRate * 0.48;
 
-  const int numSamples = buffer.getNumSamples();
+  if (force || micMode != designedMicMode) {
+    designedMicMode = micMode;
+    lfPoleFilter.setHighpass(sampleRate, micMode ? 50.0 : 60.0, 0.7);
+    point.stages[1] = lfPoleFilter.getSvfCoefficients();
+    point.changedStages |= 0x2;
+  }
 
-  // Advance smoothed filter parameters and recalculate coefficients
-  // when they are still ramping or when mode/zLoad changed (dirty flag).
-  // This prevents harsh transients from instant coefficient jumps.
-  bool needFilterUpdate = filtersDirty.exchange(false, std::memory_order_acquire);
-  if (ironParam.isSmoothing() || hfRollParam.isSmoothing())
-    needFilterUpdate = true;
-  if (needFilterUpdate) {
-    ironParam.skip(numSamples);
-    hfRollParam.skip(numSamples);
-    updateFilters();
-  }
-  const int inputChannels = buffer.getNumChannels();
-
-  // Safety: skip processing if block exceeds pre-allocated capacity
-  jassert(numSamples <= maxPreparedBlockSize);
-  if (numSamples > doubleBuffer.getNumSamples())
-    return;
+  if (force || highZLoad != designedHighZLoad) {
+    designedHighZLoad = highZLoad;
+    hfResonanceFilter.setPeak(sampleRate, juce::jmin(14000.0, maxFreq), 1.5, highZLoad ? 1.2 : 0.8);
+    point.stages[2] = hfResonanceFilter.getSvfCoefficients();
+    point.changedStages |= 0x4;
+  }
+}
 
-  doubleBuffer.clear();
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::updateControls(ControlPoint &point) {
+  point.changedStages = 0;
+  point.shaperModeChanged = false;
+  const auto previousShaperMode = shaperMode;
+
+  // Commands due by this boundary, in arrival order: those held back at an
+  // earlier boundary first, then the queue. Commands not yet due are held
+  // back, unless the held list is full, when the queue waits behind them.
+  int numKept = 0;
+  for (int i = 0; i < numPendingCommands; ++i) {
+    const auto &command = pendingCommands[(size_t)i];
+    if (command.sampleTime <= samplePosition)
+      applyCommand(command);
+    else
+      pendingCommands[(size_t)numKept++] = command;
+  }
+  numPendingCommands = numKept;
+
+  while (auto *command = commands.peek()) {
+    if (command->sampleTime <= samplePosition)
+      applyCommand(*command);
+    else if (numPendingCommands < commandCapacity)
+      pendingCommands[(size_t)numPendingCommands++] = *command;
+    else
+      break;
+    commands.pop();
+  }
+
+  // Mic mode / Z load switched: redesign only the stage that depends on it
+  updateSwitchedFilters(point);
+
+  // Ramps take the smoothed value at the end of the interval, as a table
+  // lookup. This prevents harsh transients from instant coefficient jumps.
+  // The interval that ends a ramp designs the target exactly, so settled
+  // filters carry no interpolation error.
+  if (ironParam.isSmoothing()) {
+    const double iron = ironParam.skip(controlInterval);
+    if (ironParam.isSmoothing()) {
+      point.stages[0] = ironTable.lookup(iron);
+    } else {
+      designIron(ironFilter, iron);
+      point.stages[0] = ironFilter.getSvfCoefficients();
+    }
+    point.changedStages |= 0x1;
+  }
+  if (hfRollParam.isSmoothing()) {
+    const double hfRoll = hfRollParam.skip(controlInterval);
+    if (hfRollParam.isSmoothing()) {
+      point.stages[3] = hfRollTable.lookup(hfRoll * hfRollTableScale);
+    } else {
+      designHFRoll(hfRollFilter, hfRoll);
+      point.stages[3] = hfRollFilter.getSvfCoefficients();
+    }
+    point.changedStages |= 0x8;
+  }
 
-  for (int ch = 0; ch < 2; ++ch) {
-    int sourceCh = (ch < inputChannels) ? ch : 0;
+  if (shaperMode != previousShaperMode) {
+    point.shaperMode = shaperMode;
+    point.shaperModeChanged = true;
+  }
 
-    if (sourceCh >= inputChannels) {
-      doubleBuffer.clear(ch, 0, numSamples);
-      continue;
+  return point.changedStages != 0 || point.shaperModeChanged;
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::applyCommand(const EngineCommand &command) {
+  using Type = EngineCommand::Type;
+  switch (command.type) {
+  case Type::DRIVE:
+    driveParam.setTargetValue(command.value);
+    break;
+  case Type::IRON:
+    ironParam.setTargetValue(command.value);
+    break;
+  case Type::HF_ROLL:
+    hfRollParam.setTargetValue(command.value);
+    break;
+  case Type::MIC_MODE:
+    micMode = command.value != 0.0;
+    break;
+  case Type::HI_Z_LOAD:
+    highZLoad = command.value != 0.0;
+    break;
+  case Type::BYPASS:
+    bypassed = command.value != 0.0;
+    break;
+  case Type::SHAPER_MODE:
+    shaperMode = command.shaperMode;
+    break;
+  case Type::MIX:
+    mixParam.setTargetValue(command.value);
+    break;
+  case Type::LOW_LATENCY:
+    lowLatency = command.value != 0.0;
+    break;
+  case Type::PARAMETERS:
+    driveParam.setTargetValue(command.parameters.drive);
+    ironParam.setTargetValue(command.parameters.iron);
+    hfRollParam.setTargetValue(command.parameters.hfRoll);
+    micMode = command.parameters.micMode;
+    highZLoad = command.parameters.hiZLoad;
+    mixParam.setTargetValue(command.parameters.mix);
+    break;
+  }
+}
+
+template <typename SampleType>
+int NeveTransformerEngine<SampleType>::scheduleBlock(int numSamples, int &numPoints,
+                                                     int sleepCheckFrom) {
+  // Walks the block along the control grid: control points where anything
+  // changes, plus the per-sample drive ramp. Stops early at a boundary that
+  // engages bypass; that boundary's changes become the last control point.
+  // Also stops at the first sleep check from sleepCheckFrom on, so the check
+  // sees the state exactly there, and before a boundary that switches
+  // low-latency mode, which takes effect between chunks.
+  numPoints = 0;
+  chunkMixes = false;
+  int pos = 0;
+  oversampler.setLowLatency(lowLatency);
+  while (pos < numSamples) {
+    if (pos > 0 && pos >= sleepCheckFrom && samplePosition % sleepCheckInterval == 0)
+      break;
+
+    if (controlPhase == 0 && !boundaryUpdated) {
+      boundaryUpdated = true;
+      auto &point = controlPoints[(size_t)numPoints];
+      if (updateControls(point)) {
+        point.start = pos;
+        ++numPoints;
+      }
+      if (bypassed)
+        break;
+      if (lowLatency != oversampler.isLowLatency()) {
+        if (pos > 0)
+          break;
+        oversampler.setLowLatency(lowLatency);
+      }
     }
 
-    auto *input = buffer.getReadPointer(sourceCh);
-    auto *output = doubleBuffer.getWritePointer(ch);
+    const int length = juce::jmin(controlInterval - controlPhase, numSamples - pos);
+    for (int i = 0; i < length; ++i)
+      driveValues[(size_t)(pos + i)] = driveParam.getNextValue();
+    chunkMixes = chunkMixes || mixParam.isSmoothing() || mixParam.getTargetValue() < 1.0;
+    for (int i = 0; i < length; ++i)
+      mixValues[(size_t)(pos + i)] = (float)mixParam.getNextValue();
 
-    for (int i = 0; i < numSamples; ++i) {
-      double sample = static_cast<double>(input[i]);
+    pos += length;
+    advanceGrid(length);
+  }
+  return pos;
+}
 
-      sample = ironFilter[ch].process(sample);
-      sample = lfPoleFilter[ch].process(sample);
-      sample = hfResonanceFilter[ch].process(sample);
-      sample = hfRollFilter[ch].process(sample);
+template <typename SampleType>
+int NeveTransformerEngine<SampleType>::skipUnprocessed(int numSamples) {
+  // Bypassed or asleep: keeps the grid, the command queue and the smoothers
+  // moving exactly as processing would. Stops where bypass is released,
+  // unless asleep, and before a low-latency switch, so the dry delay of a
+  // bypassed stretch is constant.
+  int pos = 0;
+  oversampler.setLowLatency(lowLatency);
+  while (pos < numSamples) {
+    if (controlPhase == 0 && !boundaryUpdated) {
+      boundaryUpdated = true;
+      ControlPoint point;
+      if (updateControls(point))
+        for (auto &cascade : preFilters)
+          applyControlPoint(cascade, point);
+      if (!bypassed && !sleeping)
+        break;
+      if (lowLatency != oversampler.isLowLatency()) {
+        if (pos > 0)
+          break;
+        oversampler.setLowLatency(lowLatency);
+      }
+    }
 
-      output[i] = sample;
+    const int length = juce::jmin(controlInterval - controlPhase, numSamples - pos);
+    for (int i = 0; i < length; ++i) {
+      driveParam.getNextValue();
+      mixParam.getNextValue();
     }
+
+    pos += length;
+    advanceGrid(length);
   }
+  return pos;
+}
 
-  // Safety: skip oversampling if block exceeds prepared size
-  jassert(numSamples <= oversampler.getPreparedBlockSize());
-  if (numSamples > oversampler.getPreparedBlockSize())
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::advanceGrid(int numSamples) {
+  controlPhase = (controlPhase + numSamples) % controlInterval;
+  samplePosition += numSamples;
+  boundaryUpdated = false;
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::applyControlPoint(SvfCascade<4, SampleType> &cascade,
+                                                         const ControlPoint &point) {
+  for (size_t stage = 0; stage < 4; ++stage)
+    if (point.changedStages & (1u << stage))
+      cascade.setStage(stage, point.stages[stage]);
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::processBlock(juce::AudioBuffer<float> &buffer) {
+  // Channels beyond the prepared count pass through unprocessed
+  jassert(buffer.getNumChannels() <= numChannels);
+  const int activeChannels = juce::jmin(buffer.getNumChannels(), numChannels);
+  jassert(maxPreparedBlockSize > 0); // prepare() first
+  if (activeChannels == 0 || maxPreparedBlockSize <= 0)
     return;
+  std::fill(inputLevels.begin(), inputLevels.end(), 0.0f);
+  std::fill(outputLevels.begin(), outputLevels.end(), 0.0f);
 
-  juce::dsp::AudioBlock<double> block(doubleBuffer.getArrayOfWritePointers(), 2, (size_t)numSamples);
-  juce::dsp::AudioBlock<double> oversampledBlock = oversampler.upsample(block);
+  // Any length: chunks of at most the prepared size through the fixed work
+  // buffers. The control grid makes the split invisible in the output.
+  // Bypassed stretches output the dry signal delayed by the current latency.
+  const int numSamples = buffer.getNumSamples();
+  for (int pos = 0; pos < numSamples;) {
+    const int length = juce::jmin(maxPreparedBlockSize, numSamples - pos);
+    writeDry(buffer, pos, length, activeChannels);
+
+    if (sleeping) {
+      // Asleep until the first non-silent input sample
+      const int silent = countLeadingSilence(buffer, pos, length, activeChannels);
+      if (silent > 0) {
+        silentRun += silent;
+        pos += skipUnprocessed(silent);
+        continue;
+      }
+      sleeping = false;
+    }
 
-  const int oversampledSamples =
-      static_cast<int>(oversampledBlock.getNumSamples());
+    if (bypassed) {
+      const int skipped = skipUnprocessed(length);
+      readDry(buffer, pos, skipped, samplePosition - skipped, activeChannels);
+      pos += skipped;
+    } else {
+      pos += processChunk(buffer, pos, length, activeChannels);
+    }
+  }
+
+  publishedPosition.store(samplePosition, std::memory_order_release);
+}
 
-  // Step driveParam once per base-rate sample to maintain correct smoothing rate.
-  // Update waveshaper drive from the smoothed value (not target) to avoid zipper noise.
-  const int oversampleFactor = 4;
-  for (int baseSample = 0; baseSample < numSamples; ++baseSample) {
-    double currentDrive = driveParam.getNextValue();
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::writeDry(const juce::AudioBuffer<float> &buffer,
+                                                 int startSample, int numSamples,
+                                                 int activeChannels) {
+  // startSample is at samplePosition; a chunk cut short leaves the rest of
+  // its input already written, and about to be overwritten with output.
+  // Each input sample passes through here exactly once, so it is metered here.
+  ScopedStageTimer timer(profiler, ProfileStage::DRY_COPY);
+  const juce::int64 end = samplePosition + numSamples;
+  for (int ch = 0; ch < activeChannels; ++ch) {
+    const float *input = buffer.getReadPointer(ch, startSample);
+    float *ring = dryDelay.getWritePointer(ch);
+    float peak = inputLevels[(size_t)ch];
+    for (auto position = juce::jmax(dryWritten, samplePosition); position < end; ++position) {
+      const float sample = input[position - samplePosition];
+      ring[position & dryDelayMask] = sample;
+      peak = juce::jmax(peak, std::abs(sample));
+    }
+    inputLevels[(size_t)ch] = peak;
+  }
+  dryWritten = juce::jmax(dryWritten, end);
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::readDry(juce::AudioBuffer<float> &buffer,
+                                                int startSample, int numSamples,
+                                                juce::int64 streamPosition,
+                                                int activeChannels) {
+  ScopedStageTimer timer(profiler, ProfileStage::DRY_COPY);
+  const juce::int64 delayed = streamPosition - oversampler.getLatencySamples();
+  for (int ch = 0; ch < activeChannels; ++ch) {
+    const float *ring = dryDelay.getReadPointer(ch);
+    float *output = buffer.getWritePointer(ch, startSample);
+    float peak = outputLevels[(size_t)ch];
+    for (int i = 0; i < numSamples; ++i) {
+      output[i] = ring[(delayed + i) & dryDelayMask];
+      peak = juce::jmax(peak, std::abs(output[i]));
+    }
+    outputLevels[(size_t)ch] = peak;
+  }
+}
+
+template <typename SampleType>
+int NeveTransformerEngine<SampleType>::processChunk(juce::AudioBuffer<float> &buffer,
+                                                    int startSample, int numSamples,
+                                                    int activeChannels) {
+  const auto blockStartShaperMode = shaperMode;
+  const juce::int64 chunkStart = samplePosition;
+
+  // Input silence, read before the buffer is overwritten: where sleep checks
+  // become possible in this chunk
+  int lastSound = findLastSound(buffer, startSample, numSamples, activeChannels);
+  const juce::int64 sleepCheckFrom =
+      lastSound + 1 + juce::jmax<juce::int64>(0, minSilentSamples - (lastSound < 0 ? silentRun : 0));
+
+  int numControlPoints = 0;
+  const int requestedSamples = numSamples;
+  numSamples = scheduleBlock(numSamples, numControlPoints,
+                             (int)juce::jmin<juce::int64>(sleepCheckFrom, numSamples));
+  if (numSamples < requestedSamples && lastSound >= numSamples)
+    lastSound = findLastSound(buffer, startSample, numSamples, activeChannels);
+  const juce::int64 dryStart = chunkStart - oversampler.getLatencySamples();
+
+  if (numSamples == 0) {
+    // Bypass engaged right at the chunk start
+    for (auto &cascade : preFilters)
+      for (int point = 0; point < numControlPoints; ++point)
+        applyControlPoint(cascade, controlPoints[(size_t)point]);
+    resetState();
+    return 0;
+  }
 
-    // Update waveshaper drive from smoothed value
-    for (int ch = 0; ch < 2; ++ch)
-      waveshaper[ch].setDrive(currentDrive);
+  // Pre-filters, one SIMD group of channels at a time (one channel per lane)
+  auto *frames = reinterpret_cast<SampleType *>(frameBuffer.data());
+  for (int group = 0; group * (int)numLanes < activeChannels; ++group) {
+    const int first = group * (int)numLanes;
+    const int count = juce::jmin((int)numLanes, activeChannels - first);
+    auto &cascade = preFilters[(size_t)group];
+    ScopedStageTimer timer(profiler, ProfileStage::PRE_FILTERS);
+
+    interleave(frames, buffer.getArrayOfReadPointers() + first, count, startSample, numSamples);
+    int pos = 0;
+    for (int point = 0; point < numControlPoints; ++point) {
+      const auto &control = controlPoints[(size_t)point];
+      cascade.process(frameBuffer.data() + pos, control.start - pos);
+      applyControlPoint(cascade, control);
+      pos = control.start;
+    }
+    cascade.process(frameBuffer.data() + pos, numSamples - pos);
+    deinterleave(workBuffer.getArrayOfWritePointers() + first, frames, count, numSamples);
+  }
 
-    for (int os = 0; os < oversampleFactor; ++os) {
-      int i = baseSample * oversampleFactor + os;
-      if (i >= oversampledSamples) break;
+  juce::dsp::AudioBlock<SampleType> block(workBuffer.getArrayOfWritePointers(),
+                                          (size_t)activeChannels, (size_t)numSamples);
+  juce::dsp::AudioBlock<SampleType> oversampledBlock;
+  {
+    ScopedStageTimer timer(profiler, ProfileStage::UPSAMPLE);
+    oversampledBlock = oversampler.upsample(block);
+  }
 
-      for (int ch = 0; ch < 2; ++ch) {
-        auto *samples = oversampledBlock.getChannelPointer(static_cast<size_t>(ch));
-        if (samples == nullptr) continue;
+  const int oversampledSamples =
+      static_cast<int>(oversampledBlock.getNumSamples());
 
-        double sample = samples[i];
+  // Drive was stepped once per base-rate sample by scheduleBlock; update the
+  // waveshaper from the smoothed value (not target) to avoid zipper noise.
+  const int oversampleFactor = oversampler.getFactor();
+
+  // Channel by channel, so each one's state stays in registers
+  for (int ch = 0; ch < activeChannels; ++ch) {
+    auto *samples = oversampledBlock.getChannelPointer(static_cast<size_t>(ch));
+    auto &shaper = waveshaper[(size_t)ch];
+    auto &phase = allpass[(size_t)ch];
+    ScopedStageTimer timer(profiler, ProfileStage::CORE);
+    shaper.setMode(blockStartShaperMode);
+    int point = 0;
+
+    for (int baseSample = 0; baseSample < numSamples; ++baseSample) {
+      if (point < numControlPoints && controlPoints[(size_t)point].start == baseSample) {
+        const auto &control = controlPoints[(size_t)point++];
+        if (control.shaperModeChanged)
+          shaper.setMode(control.shaperMode);
+      }
 
-        double coreState = allpass[ch].getCoreState();
-        sample = waveshaper[ch].processWithHysteresis(sample, coreState, ch);
-        sample = allpass[ch].process(sample, currentDrive);
+      const double currentDrive = driveValues[(size_t)baseSample];
+      const auto allpassDrive = static_cast<SampleType>(currentDrive);
+      shaper.setDrive(currentDrive);
 
-        samples[i] = sample;
+      const int end = juce::jmin((baseSample + 1) * oversampleFactor, oversampledSamples);
+      for (int i = baseSample * oversampleFactor; i < end; ++i) {
+        SampleType coreState = phase.getCoreState();
+        SampleType sample = shaper.processWithHysteresis(samples[i], coreState, ch);
+        samples[i] = phase.process(sample, allpassDrive);
       }
     }
   }
 
-  oversampler.downsample(block);
+  {
+    ScopedStageTimer timer(profiler, ProfileStage::DOWNSAMPLE);
+    oversampler.downsample(block);
+  }
 
-  for (int ch = 0; ch < inputChannels && ch < 2; ++ch) {
-    auto *input = doubleBuffer.getReadPointer(ch);
-    auto *output = buffer.getWritePointer(ch);
+  // Output peak since the last sleep check boundary: samples from peakFrom on
+  const juce::int64 lastCheck = ((samplePosition - 1) / sleepCheckInterval) * sleepCheckInterval;
+  const int peakFrom = lastCheck > chunkStart ? (int)(lastCheck - chunkStart) : 0;
+  float checkPeak = 0.0f;
+
+  // Post-filters, then soft limit, wet/dry blend and output metering in one
+  // pass back into the float buffer
+  for (int group = 0; group * (int)numLanes < activeChannels; ++group) {
+    const int first = group * (int)numLanes;
+    const int count = juce::jmin((int)numLanes, activeChannels - first);
+
+    {
+      ScopedStageTimer timer(profiler, ProfileStage::POST_FILTERS);
+      interleave(frames, workBuffer.getArrayOfReadPointers() + first, count, 0, numSamples);
+      postFilters[(size_t)group].process(frameBuffer.data(), numSamples);
+    }
 
-    for (int i = 0; i < numSamples; ++i) {
-      double sample = input[i];
-      sample = postShelfFilter[ch].process(sample);
-      sample = dcBlocker[ch].process(sample);
-      // Soft limit to prevent DAC clipping
-      if (sample > 1.0)
-        sample = 1.0 - std::exp(-(sample - 1.0));
-      else if (sample < -1.0)
-        sample = -(1.0 - std::exp(-(-sample - 1.0)));
-      output[i] = static_cast<float>(sample);
+    ScopedStageTimer timer(profiler, ProfileStage::SOFT_LIMIT);
+    for (int lane = 0; lane < count; ++lane) {
+      const int ch = first + lane;
+      auto *output = buffer.getWritePointer(ch, startSample);
+      // The dry input delayed to line up with the wet
+      const float *dry = chunkMixes ? dryDelay.getReadPointer(ch) : nullptr;
+      float peaks[2] = { 0.0f, 0.0f }; // before and from peakFrom
+
+      for (int part = 0; part < 2; ++part) {
+        const int end = part == 0 ? peakFrom : numSamples;
+        for (int i = part == 0 ? 0 : peakFrom; i < end; ++i) {
+          float sample = static_cast<float>(softLimit(frames[(size_t)i * numLanes + (size_t)lane]));
+          if (dry != nullptr) {
+            const float mix = mixValues[(size_t)i];
+            sample = sample * mix + dry[(dryStart + i) & dryDelayMask] * (1.0f - mix);
+          }
+          output[i] = sample;
+          peaks[part] = juce::jmax(peaks[part], std::abs(sample));
+        }
+      }
+
+      outputLevels[(size_t)ch] = juce::jmax(outputLevels[(size_t)ch], peaks[0], peaks[1]);
+      checkPeak = juce::jmax(checkPeak, peaks[1]);
     }
   }
+  outputPeak = juce::jmax(peakFrom > 0 ? 0.0f : outputPeak, checkPeak);
+
+  silentRun = lastSound < 0 ? silentRun + numSamples : numSamples - lastSound - 1;
+  if (samplePosition % sleepCheckInterval == 0) {
+    if (silentRun >= minSilentSamples && outputPeak < (float)sleepThreshold && isQuiet()) {
+      resetState();
+      sleeping = true;
+    }
+    outputPeak = 0.0f;
+  }
+
+  // Bypass engaged at the boundary ending this chunk
+  if (bypassed)
+    resetState();
+  return numSamples;
 }
 
-int NeveTransformerDSP::getLatencySamples() const {
+template <typename SampleType>
+int NeveTransformerEngine<SampleType>::getLatencySamples() const {
   return oversampler.getLatencySamples();
 }
 
-void NeveTransformerDSP::setDrive(double value) {
-  driveParam.setTargetValue(juce::jlimit(0.0, 1.0, value));
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setDrive(double value, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::DRIVE, juce::jlimit(0.0, 1.0, value), sampleTime));
 }
 
-void NeveTransformerDSP::setIron(double value) {
-  ironParam.setTargetValue(juce::jlimit(0.0, 1.0, value));
-  filtersDirty.store(true, std::memory_order_release);
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setIron(double value, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::IRON, juce::jlimit(0.0, 1.0, value), sampleTime));
 }
 
-void NeveTransformerDSP::setHFRoll(double value) {
-  hfRollParam.setTargetValue(juce::jlimit(0.0, 1.0, value));
-  filtersDirty.store(true, std::memory_order_release);
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setHFRoll(double value, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::HF_ROLL, juce::jlimit(0.0, 1.0, value), sampleTime));
 }
 
-void NeveTransformerDSP::setMode(bool isMic) {
-  micMode.store(isMic, std::memory_order_release);
-  filtersDirty.store(true, std::memory_order_release);
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setMode(bool isMic, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::MIC_MODE, isMic ? 1.0 : 0.0, sampleTime));
 }
 
-void NeveTransformerDSP::setZLoad(bool isHigh) {
-  highZLoad.store(isHigh, std::memory_order_release);
-  filtersDirty.store(true, std::memory_order_release);
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setZLoad(bool isHigh, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::HI_Z_LOAD, isHigh ? 1.0 : 0.0, sampleTime));
 }
 
-void NeveTransformerDSP::setBypassed(bool shouldBypass) {
-  bypassed.store(shouldBypass, std::memory_order_release);
-  if (shouldBypass)
-    reset();
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setBypassed(bool shouldBypass, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::BYPASS, shouldBypass ? 1.0 : 0.0, sampleTime));
 }
+
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setLowLatency(bool shouldBeLowLatency,
+                                                      juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::LOW_LATENCY, shouldBeLowLatency ? 1.0 : 0.0,
+                          sampleTime));
+}
+
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setMix(double value, juce::int64 sampleTime) {
+  return pushCommand(makeCommand(EngineCommand::Type::MIX, juce::jlimit(0.0, 1.0, value), sampleTime));
+}
+
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setWaveshaperMode(WaveshaperMode newMode,
+                                                          juce::int64 sampleTime) {
+  auto command = makeCommand(EngineCommand::Type::SHAPER_MODE, 0.0, sampleTime);
+  command.shaperMode = newMode;
+  return pushCommand(command);
+}
+
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::setParameters(const EngineParameters &parameters,
+                                                      juce::int64 sampleTime) {
+  auto command = makeCommand(EngineCommand::Type::PARAMETERS, 0.0, sampleTime);
+  command.parameters = parameters;
+  command.parameters.drive = juce::jlimit(0.0, 1.0, parameters.drive);
+  command.parameters.iron = juce::jlimit(0.0, 1.0, parameters.iron);
+  command.parameters.hfRoll = juce::jlimit(0.0, 1.0, parameters.hfRoll);
+  command.parameters.mix = juce::jlimit(0.0, 1.0, parameters.mix);
+  return pushCommand(command);
+}
+
+template <typename SampleType>
+bool NeveTransformerEngine<SampleType>::pushCommand(const EngineCommand &command) {
+  const bool queued = commands.push(command);
+  jassert(queued); // Queue full: the audio thread isn't draining it
+  return queued;
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::setOversamplingFactor(int factor) {
+  int factorLog2 = 0;
+  while (factorLog2 < 4 && (2 << factorLog2) <= factor)
+    ++factorLog2;
+  oversampler.setFactorLog2(factorLog2);
+}
+
+template <typename SampleType>
+void NeveTransformerEngine<SampleType>::setOversamplingFilter(OversamplingFilter type) {
+  oversampler.setFilterType(type);
+}
+
+template class NeveTransformerEngine<float>;
+template class NeveTransformerEngine<double>;
@@ -1,72 +1,284 @@
 #pragma once
 
 #include "BiquadFilter.h"
+#include "CommandQueue.h"
+#include "CoefficientTable.h"
 #include "DynamicAllpass.h"
 #include "Oversampler.h"
+#include "StageProfiler.h"
+#include "StateArchive.h"
+#include "SvfCascade.h"
 #include "Waveshaper.h"
 #include <juce_audio_basics/juce_audio_basics.h>
-#include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_dsp/juce_dsp.h>
 #include <atomic>
+#include <limits>
+#include <vector>
 
 /**
  * Complete Neve transformer emulation DSP processor
  * Signal chain: Pre-filter (IIR) -> Oversample -> Nonlinear Core -> Downsample ->
  * Post-filter
+ *
+ * Every stage runs in SampleType. The float engine doubles the SIMD width and
+ * halves memory traffic; the double engine is the mastering/reference path.
+ * Coefficients are always designed in double.
  */
-class NeveTransformerDSP {
+template <typename SampleType>
+class NeveTransformerEngine {
 public:
-  NeveTransformerDSP();
+  NeveTransformerEngine();
 
-  void prepare(double sampleRate, int maxBlockSize);
+  /**
+   * Any channel count: channels are processed in SIMD groups of numLanes,
+   * so cost grows linearly with it. Buffers with fewer channels process only
+   * those; channels beyond the prepared count are left untouched.
+   */
+  void prepare(double sampleRate, int maxBlockSize, int numChannels = 2);
+  /** Clears filter, shaper and oversampler state; only while audio is stopped */
   void reset();
+  /**
+   * In place, any length: longer blocks are processed in prepared-size chunks.
+   * The buffer may refer straight to the device buffer: input and output
+   * levels are metered in the passes that already read and write each sample.
+   */
   void processBlock(juce::AudioBuffer<float> &buffer);
 
-  // Parameter setters (0-1 normalized)
-  void setDrive(double value);
-  void setIron(double value);
-  void setHFRoll(double value);
-  void setMode(bool isMic);
-  void setZLoad(bool isHigh);
-  void setBypassed(bool shouldBypass);
+  /** Audio thread: peak magnitude per channel over the last processBlock() */
+  float getInputLevel(int channel) const { return inputLevels[(size_t)channel]; }
+  float getOutputLevel(int channel) const { return outputLevels[(size_t)channel]; }
+
+  // Parameter setters (0-1 normalized). Each queues a command that the audio
+  // thread applies at the first control-grid boundary at or after sampleTime
+  // (see getSamplePosition(); -1 = next boundary), whatever the timestamps of
+  // the commands queued before it. Call them from one thread only (single
+  // producer). Each returns false if the queue was full and the change was
+  // dropped, so the caller can send it again.
+  bool setDrive(double value, juce::int64 sampleTime = -1);
+  bool setIron(double value, juce::int64 sampleTime = -1);
+  bool setHFRoll(double value, juce::int64 sampleTime = -1);
+  bool setMode(bool isMic, juce::int64 sampleTime = -1);
+  bool setZLoad(bool isHigh, juce::int64 sampleTime = -1);
+  /** Bypassed stretches output the delayed dry signal; state is cleared on engaging */
+  bool setBypassed(bool shouldBypass, juce::int64 sampleTime = -1);
+
+  /**
+   * Wet/dry mix (1 = fully wet, default), smoothed like drive. The dry path
+   * runs through a delay line that follows getLatencySamples(), so parallel
+   * blends never comb-filter; bypass outputs the same delayed dry signal.
+   */
+  bool setMix(double mix, juce::int64 sampleTime = -1);
+
+  /** Selects the fast tanh approximation (default), std::tanh reference or ADAA */
+  bool setWaveshaperMode(WaveshaperMode newMode, juce::int64 sampleTime = -1);
+
+  /** All user parameters as one command, so presets and A/B switch atomically */
+  bool setParameters(const EngineParameters &parameters, juce::int64 sampleTime = -1);
+
+  /** Queues a command, optionally timestamped; false if the queue is full */
+  bool pushCommand(const EngineCommand &command);
+
+  /** Stream samples processed since prepare()/reset(), for timestamps */
+  juce::int64 getSamplePosition() const { return publishedPosition.load(std::memory_order_acquire); }
+
+  /**
+   * Low-latency monitoring: oversample through minimum-latency polyphase IIR
+   * halfbands instead of the configured filter. Switches at a control-grid
+   * boundary without allocating (both are prepared); getLatencySamples()
+   * follows once the audio thread has switched.
+   */
+  bool setLowLatency(bool shouldBeLowLatency, juce::int64 sampleTime = -1);
+  bool isLowLatency() const { return oversampler.isLowLatency(); }
+
+  /** Oversampling 1x-16x (default 4x) and filter design; take effect on the next prepare() */
+  void setOversamplingFactor(int factor);
+  void setOversamplingFilter(OversamplingFilter type);
+  int getOversamplingFactor() const { return oversampler.getFactor(); }
+  OversamplingFilter getOversamplingFilter() const { return oversampler.getFilterType(); }
+
+  /**
+   * Idle sleep (default on): once the input has been digital silence long
+   * enough for every filter, envelope and oversampler tail to fall below
+   * -120 dBFS, processing stops and silent blocks pass through untouched.
+   * The first non-zero input sample wakes the engine with cleared state.
+   * Takes effect on the next prepare().
+   */
+  void setIdleSleepEnabled(bool shouldSleep) { idleSleepEnabled = shouldSleep; }
+  /** Audio thread, or while audio is stopped */
+  bool isSleeping() const { return sleeping; }
+
+  /**
+   * Runtime state as a binary blob of getStateSize() bytes, fixed once
+   * prepared: filter, shaper, oversampler and dry delay memory, parameter
+   * ramps, switches and the stream position. Audio thread between blocks, or
+   * while audio is stopped; neither call allocates or locks. A restored
+   * engine carries on as the saved one would have (to within rounding), so
+   * exports can resume from a checkpoint, segment renders start warm and A/B
+   * switches have no reset transient. Restoring fails and changes nothing
+   * unless this engine was prepared with the same sample rate, channel
+   * count, oversampling and precision. Queued commands aren't part of it.
+   * Needs setStateCaptureEnabled(true): otherwise the size is 0 and both
+   * calls fail.
+   */
+  size_t getStateSize() const { return stateSize; }
+  bool saveState(void *data, size_t size);
+  bool restoreState(const void *data, size_t size);
+
+  /**
+   * Keeps the oversampler history saveState() needs (default off: it costs
+   * a copy of every block). Takes effect on the next prepare().
+   */
+  void setStateCaptureEnabled(bool shouldCapture) { stateCaptureEnabled = shouldCapture; }
+
+  /** Times each processing stage into profiler (nullptr = off); set while audio is stopped */
+  void setProfiler(StageProfiler *newProfiler) { profiler = newProfiler; }
 
   int getLatencySamples() const;
+  int getNumChannels() const { return numChannels; }
 
 private:
-  void updateFilters();
+  // SVF topology in both precisions: direct-form biquads with poles at a few
+  // Hz fall apart in float, and sharing one topology keeps the float and
+  // double engines within rounding of each other, even while coefficients move
+  using FilterVec = typename SvfCascade<4, SampleType>::Vec;
+  static constexpr size_t numLanes = SvfCascade<4, SampleType>::numLanes;
+
+  // Everything that changes at one control-grid boundary
+  struct ControlPoint {
+    int start = 0;              // offset into the current block
+    unsigned changedStages = 0; // bit s set: pre-filter stage s takes stages[s]
+    BiquadFilter::SvfCoefficients stages[4];
+    bool shaperModeChanged = false;
+    WaveshaperMode shaperMode = WaveshaperMode::FAST;
+  };
+
+  // Parameter changes are latched, and iron/HF roll ramps step, on a fixed
+  // grid of controlInterval samples counted from prepare()/reset() rather
+  // than from each host block, so the output does not depend on how the
+  // stream is split into blocks
+  static constexpr int controlInterval = 32;
+
+  // Sleep is only considered at multiples of sleepCheckInterval stream
+  // samples, from the state and the output peak since the previous check,
+  // so it engages at the same sample whatever the block sizes
+  static constexpr int sleepCheckInterval = 1024;
+  static constexpr double sleepThreshold = 1.0e-6; // -120 dBFS
+
+  // Leads every state blob; bump the last byte whenever the layout changes
+  static constexpr juce::uint32 stateTag = 0x4e545331; // "NTS1"
+
+  int processChunk(juce::AudioBuffer<float> &buffer, int startSample, int numSamples,
+                   int activeChannels);
+  void buildCoefficientTables();
+  void designIron(BiquadFilter &filter, double iron) const;
+  void designHFRoll(BiquadFilter &filter, double hfRoll) const;
+  void updateSwitchedFilters(ControlPoint &point, bool force = false);
+  bool updateControls(ControlPoint &point);
+  void applyCommand(const EngineCommand &command);
+  int scheduleBlock(int numSamples, int &numPoints, int sleepCheckFrom);
+  int skipUnprocessed(int numSamples);
+  void writeDry(const juce::AudioBuffer<float> &buffer, int startSample, int numSamples,
+                int activeChannels);
+  void readDry(juce::AudioBuffer<float> &buffer, int startSample, int numSamples,
+               juce::int64 streamPosition, int activeChannels);
+  void advanceGrid(int numSamples);
+  static void applyControlPoint(SvfCascade<4, SampleType> &cascade, const ControlPoint &point);
+  void resetState();
+  bool isQuiet() const;
+  bool transferState(StateArchive &archive);
 
   double sampleRate = 48000.0;
   int maxPreparedBlockSize = 0;
+  int numChannels = 2;
+
+  // Setter commands, drained by the audio thread at grid boundaries. Those
+  // timestamped past the boundary wait in pendingCommands (arrival order),
+  // so they never hold up the commands queued behind them.
+  static constexpr int commandCapacity = 256;
+  SpscQueue<EngineCommand, commandCapacity> commands;
+  std::array<EngineCommand, (size_t)commandCapacity> pendingCommands {};
+  int numPendingCommands = 0;
+  juce::int64 samplePosition = 0; // stream position of the scheduler
+  std::atomic<juce::int64> publishedPosition { 0 };
 
-  // Smoothed Parameters
-  juce::LinearSmoothedValue<double> driveParam { 0.3 };
-  juce::LinearSmoothedValue<double> ironParam { 0.5 };
-  juce::LinearSmoothedValue<double> hfRollParam { 0.7 };
+  // Parameter state, owned by the audio thread once prepared
+  SmoothedParameter<double> driveParam { 0.3 };
+  SmoothedParameter<double> ironParam { 0.5 };
+  SmoothedParameter<double> hfRollParam { 0.7 };
+  SmoothedParameter<double> mixParam { 1.0 };
+  bool micMode = false;
+  bool highZLoad = true;
+  bool bypassed = false;
+  bool lowLatency = false;
+  WaveshaperMode shaperMode = WaveshaperMode::FAST;
 
-  std::atomic<bool> micMode { false };
-  std::atomic<bool> highZLoad { true };
-  std::atomic<bool> bypassed { false };
+  // Linear filter designs (coefficients only, shared by all channels).
+  // LF pole and HF resonance follow the mic/Z-load switches and are only
+  // redesigned when one flips; post shelf and DC blocker are fixed.
+  BiquadFilter lfPoleFilter;
+  BiquadFilter hfResonanceFilter;
+  BiquadFilter postShelfFilter;
+  BiquadFilter dcBlocker;
+  bool designedMicMode = false;
+  bool designedHighZLoad = true;
 
-  // Atomic dirty flag for thread-safe filter updates
-  std::atomic<bool> filtersDirty { true };
+  // Iron shelf and HF roll: tabulated over their 0-1 parameter range while
+  // ramping, designed exactly once settled
+  SvfCoefficientTable ironTable;
+  SvfCoefficientTable hfRollTable;
+  BiquadFilter ironFilter;
+  BiquadFilter hfRollFilter;
+  double hfRollTableScale = 1.0; // hfRoll -> table position
+  std::vector<ControlPoint> controlPoints;
+  int controlPhase = 0;         // samples since the last grid boundary
+  bool boundaryUpdated = false; // controls already run for this boundary
 
-  // Linear pre-transformer filters (per channel)
-  BiquadFilter lfPoleFilter[2];
-  BiquadFilter hfResonanceFilter[2];
-  BiquadFilter ironFilter[2];
-  BiquadFilter hfRollFilter[2];
+  // Idle sleep
+  bool idleSleepEnabled = true;
+  int minSilentSamples = 0;   // silent input required before a sleep check
+  juce::int64 silentRun = 0;  // input samples of digital silence so far
+  float outputPeak = 0.0f;    // since the last sleep check boundary
+  bool sleeping = false;
 
-  // Linear post-transformer filter
-  BiquadFilter postShelfFilter[2];
-  BiquadFilter dcBlocker[2];
+  // Linear filters, one cascade per group of numLanes channels
+  std::vector<SvfCascade<4, SampleType>> preFilters;  // iron -> LF pole -> HF resonance -> HF roll
+  std::vector<SvfCascade<2, SampleType>> postFilters; // post shelf -> DC blocker
+  std::vector<FilterVec> frameBuffer;
 
-  // Nonlinear core
-  Waveshaper waveshaper[2];
-  DynamicAllpass allpass[2];
+  // Nonlinear core, one per channel
+  std::vector<Waveshaper<SampleType>> waveshaper;
+  std::vector<DynamicAllpass<SampleType>> allpass;
 
   // Pre-allocated buffers for audio thread
-  juce::AudioBuffer<double> doubleBuffer;
+  juce::AudioBuffer<SampleType> workBuffer;
+  std::vector<double> driveValues; // smoothed drive per base-rate sample
+  std::vector<float> mixValues;    // smoothed mix per base-rate sample
+  bool chunkMixes = false;         // some mix value in the chunk is below 1
+
+  // Dry input by stream position (power-of-two ring), read back delayed by
+  // the current latency for the mix and for bypass
+  juce::AudioBuffer<float> dryDelay;
+  juce::int64 dryDelayMask = 0;
+  juce::int64 dryWritten = 0; // stream position written up to
+
+  // Meters of the last processBlock call, per channel
+  std::vector<float> inputLevels;
+  std::vector<float> outputLevels;
 
   // Oversampling
-  Oversampler oversampler;
+  Oversampler<SampleType> oversampler;
+
+  size_t stateSize = 0; // bytes per saved state, measured in prepare(); 0 = capture off
+  bool stateCaptureEnabled = false;
+
+  StageProfiler *profiler = nullptr;
 };
+
+extern template class NeveTransformerEngine<float>;
+extern template class NeveTransformerEngine<double>;
+
+/** Double-precision engine: offline export, mastering and reference renders */
+using NeveTransformerDSP = NeveTransformerEngine<double>;
+
+/** Single-precision engine for live playback */
+using NeveTransformerDSPFloat = NeveTransformerEngine<float>;
@@ -1,51 +1,236 @@
 #pragma once
 
+#include "StateArchive.h"
 #include <juce_dsp/juce_dsp.h>
 
+/** Halfband filter design used by Oversampler */
+enum class OversamplingFilter { FIR, IIR };
+
 /**
  * Wrapper around JUCE's oversampling for anti-aliasing
- * 4x polyphase FIR
+ * 1x-16x, linear-phase FIR (default, 4x) or low-latency polyphase IIR,
+ * for the channel count given to prepare(). A polyphase IIR instance is
+ * always prepared alongside, so low-latency mode switches at run time
+ * without allocating.
  */
+template <typename SampleType>
 class Oversampler {
 public:
-  Oversampler() {
-    // 4x oversampling with linear-phase equiripple FIR for best alias rejection
-    oversampler = std::make_unique<juce::dsp::Oversampling<double>>(
-        2, // num channels
-        2, // factor exponent (4x)
-        juce::dsp::Oversampling<double>::filterHalfBandFIREquiripple,
-        true, // isMaximumQuality
-        true  // useIntegerLatency
-    );
+  using FilterType = OversamplingFilter;
+
+  Oversampler() { create(2, 2, FilterType::FIR); }
+
+  /** Selects 2^factorLog2 oversampling (0-4); takes effect on the next prepare() */
+  void setFactorLog2(int newFactorLog2) {
+    pendingFactorLog2 = juce::jlimit(0, 4, newFactorLog2);
   }
 
-  void prepare(double sampleRate, int maxBlockSize) {
-    // Prepare oversampler
+  /** Selects the halfband filter design; takes effect on the next prepare() */
+  void setFilterType(FilterType newType) { pendingFilterType = newType; }
+
+  /**
+   * Records the history transferState() replays (default off: it copies
+   * every block on the way through). Set while audio is stopped.
+   */
+  void setHistoryEnabled(bool shouldRecord) {
+    historyEnabled = shouldRecord;
+    clearHistory();
+  }
+  bool isHistoryEnabled() const { return historyEnabled; }
+
+  void prepare(double sampleRate, int maxBlockSize, int newNumChannels = 2) {
+    newNumChannels = juce::jmax(1, newNumChannels);
+    if (newNumChannels != numChannels || pendingFactorLog2 != factorLog2 ||
+        pendingFilterType != filterType)
+      create(newNumChannels, pendingFactorLog2, pendingFilterType);
+
+    // Prepare both oversamplers
     currentMaxBlockSize = maxBlockSize;
-    oversampler->initProcessing(maxBlockSize);
-    oversampler->reset();
+    for (auto &instance : instances)
+      if (instance != nullptr) {
+        instance->initProcessing((size_t)maxBlockSize);
+        instance->reset();
+      }
+
+    inputHistory.setSize(numChannels, historyLength);
+    outputHistory.setSize(numChannels, historyLength * getFactor());
+    replayScratch.setSize(numChannels, juce::jmin(historyLength, maxBlockSize));
+    clearHistory();
   }
 
+  /**
+   * Audio thread, between blocks: routes through the polyphase IIR instance
+   * (low latency) or the configured filter. The newly active instance starts
+   * from cleared state.
+   */
+  void setLowLatency(bool shouldBeLowLatency) {
+    lowLatency.store(shouldBeLowLatency, std::memory_order_release);
+    auto *next = getInstance(shouldBeLowLatency);
+    if (next != oversampler) {
+      next->reset();
+      oversampler = next;
+      clearHistory();
+    }
+  }
+  bool isLowLatency() const { return lowLatency.load(std::memory_order_acquire); }
+
   int getPreparedBlockSize() const { return currentMaxBlockSize; }
+  int getNumChannels() const { return numChannels; }
+  int getFactor() const { return 1 << factorLog2; }
+  FilterType getFilterType() const { return filterType; }
 
-  void reset() { oversampler->reset(); }
+  void reset() {
+    oversampler->reset();
+    clearHistory();
+  }
 
+  // Integer by construction: JUCE pads IIR phase delay with a fractional delay.
+  // Safe from any thread: both instances' latencies are fixed once prepared.
   int getLatencySamples() const {
-    return static_cast<int>(oversampler->getLatencyInSamples());
+    return juce::roundToInt(getInstance(isLowLatency())->getLatencyInSamples());
+  }
+  int getMaxLatencySamples() const {
+    return juce::roundToInt(juce::jmax(getInstance(false)->getLatencyInSamples(),
+                                       getInstance(true)->getLatencyInSamples()));
   }
 
   // Upsample input block
-  juce::dsp::AudioBlock<double>
-  upsample(juce::dsp::AudioBlock<double> &inputBlock) {
-    return oversampler->processSamplesUp(inputBlock);
+  juce::dsp::AudioBlock<SampleType>
+  upsample(juce::dsp::AudioBlock<SampleType> &inputBlock) {
+    if (historyEnabled)
+      recordHistory(inputHistory, inputBlock, 1);
+    upsampledBlock = oversampler->processSamplesUp(inputBlock);
+    return upsampledBlock;
   }
 
-  // Downsample processed block
-  void downsample(juce::dsp::AudioBlock<double> &outputBlock) {
+  // Downsample processed block (the one upsample() returned)
+  void downsample(juce::dsp::AudioBlock<SampleType> &outputBlock) {
+    if (historyEnabled) {
+      recordHistory(outputHistory, upsampledBlock, getFactor());
+      historyPosition = (int)((historyPosition + outputBlock.getNumSamples()) % historyLength);
+    }
     oversampler->processSamplesDown(outputBlock);
   }
 
+  /**
+   * JUCE keeps the halfband filter state private, so the saved state is the
+   * active filter and the last historyLength base-rate input samples with
+   * the matching oversampled core output. Restoring resets the filters and
+   * replays both through them: FIR halfbands come back exactly, IIR ones and
+   * the fractional latency delay to far below the noise floor. Doesn't
+   * allocate. Needs setHistoryEnabled(true) from before the saved block.
+   */
+  void transferState(StateArchive &archive) {
+    jassert(historyEnabled);
+    bool useLowLatency = isLowLatency();
+    archive.value(useLowLatency);
+    if (archive.isRestoring())
+      historyPosition = 0; // restored oldest first
+    transferHistory(archive, inputHistory, 1);
+    transferHistory(archive, outputHistory, getFactor());
+    if (!archive.isRestoring() || !archive.isValid())
+      return;
+
+    lowLatency.store(useLowLatency, std::memory_order_release);
+    oversampler = getInstance(useLowLatency);
+    oversampler->reset();
+
+    const int chunk = replayScratch.getNumSamples();
+    const auto factor = (size_t)getFactor();
+    juce::dsp::AudioBlock<SampleType> input(inputHistory), output(outputHistory),
+        scratch(replayScratch);
+    for (int start = 0; start < historyLength; start += chunk) {
+      const auto length = (size_t)juce::jmin(chunk, historyLength - start);
+      auto upsampled = oversampler->processSamplesUp(input.getSubBlock((size_t)start, length));
+      upsampled.copyFrom(output.getSubBlock((size_t)start * factor, length * factor));
+      auto discarded = scratch.getSubBlock(0, length);
+      oversampler->processSamplesDown(discarded);
+    }
+  }
+
 private:
-  std::unique_ptr<juce::dsp::Oversampling<double>> oversampler;
+  void create(int newNumChannels, int newFactorLog2, FilterType newType) {
+    // Equiripple FIR for best alias rejection and linear phase; polyphase IIR
+    // for a fraction of the latency and cost
+    numChannels = newNumChannels;
+    factorLog2 = pendingFactorLog2 = newFactorLog2;
+    filterType = pendingFilterType = newType;
+    instances[0] = makeInstance(filterType);
+    // Low-latency instance, unless the configured one already is IIR
+    instances[1] = filterType == FilterType::IIR ? nullptr : makeInstance(FilterType::IIR);
+    oversampler = getInstance(isLowLatency());
+  }
+
+  void clearHistory() {
+    inputHistory.clear();
+    outputHistory.clear();
+    historyPosition = 0;
+  }
+
+  // Keeps the last historyLength base-rate samples of a block (scale samples
+  // each) in a ring, at the ring position of the block's base-rate start
+  void recordHistory(juce::AudioBuffer<SampleType> &ring, const juce::dsp::AudioBlock<SampleType> &block,
+                     int scale) {
+    const int numSamples = (int)block.getNumSamples() / scale;
+    const int kept = juce::jmin(numSamples, historyLength);
+    const int channels = juce::jmin((int)block.getNumChannels(), ring.getNumChannels());
+    int destination = (historyPosition + numSamples - kept) % historyLength;
+    int source = numSamples - kept;
+    for (int remaining = kept; remaining > 0;) {
+      const int length = juce::jmin(remaining, historyLength - destination);
+      for (int ch = 0; ch < channels; ++ch)
+        ring.copyFrom(ch, destination * scale, block.getChannelPointer((size_t)ch) + source * scale,
+                      length * scale);
+      source += length;
+      remaining -= length;
+      destination = 0;
+    }
+  }
+
+  // A history ring, oldest sample first
+  void transferHistory(StateArchive &archive, juce::AudioBuffer<SampleType> &ring, int scale) {
+    const int split = historyPosition * scale, total = historyLength * scale;
+    for (int ch = 0; ch < ring.getNumChannels(); ++ch) {
+      archive.items(ring.getWritePointer(ch, split), (size_t)(total - split));
+      archive.items(ring.getWritePointer(ch), (size_t)split);
+    }
+  }
+
+  juce::dsp::Oversampling<SampleType> *getInstance(bool isLowLatencyMode) const {
+    return (isLowLatencyMode && instances[1] != nullptr ? instances[1] : instances[0]).get();
+  }
+
+  std::unique_ptr<juce::dsp::Oversampling<SampleType>> makeInstance(FilterType type) const {
+    return std::make_unique<juce::dsp::Oversampling<SampleType>>(
+        (size_t)numChannels,
+        (size_t)factorLog2,
+        type == FilterType::FIR
+            ? juce::dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple
+            : juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR,
+        true, // isMaximumQuality
+        true  // useIntegerLatency
+    );
+  }
+
+  // [0] configured filter type, [1] polyphase IIR for low-latency mode
+  std::unique_ptr<juce::dsp::Oversampling<SampleType>> instances[2];
+  juce::dsp::Oversampling<SampleType> *oversampler = nullptr; // active instance
+  std::atomic<bool> lowLatency { false };
+
+  // Replayed into the filters on restore; a few hundred samples covers the
+  // longest FIR halfband chain and lets the IIR ones settle
+  static constexpr int historyLength = 256;
+  juce::AudioBuffer<SampleType> inputHistory;  // base rate
+  juce::AudioBuffer<SampleType> outputHistory; // oversampled core output
+  juce::AudioBuffer<SampleType> replayScratch;
+  juce::dsp::AudioBlock<SampleType> upsampledBlock;
+  int historyPosition = 0; // ring index of the next base-rate sample
+  bool historyEnabled = false;
+
   int currentMaxBlockSize = 0;
+  int numChannels = 2;
+  int factorLog2 = 2;
+  int pendingFactorLog2 = 2;
+  FilterType filterType = FilterType::FIR;
+  FilterType pendingFilterType = FilterType::FIR;
 };
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+/**
+ * Lock-free duration histogram: one thread records, any thread reads.
+ * 128 log-spaced nanosecond bins, four per octave (up to ~2 s), so
+ * percentiles are within 19% of the true value; min, max and mean are exact.
+ */
+class LatencyHistogram {
+public:
+  static constexpr int numBins = 128;
+
+  struct Stats {
+    juce::uint64 count = 0;
+    double minUs = 0.0, meanUs = 0.0, p99Us = 0.0, p999Us = 0.0, maxUs = 0.0;
+  };
+
+  /** Writer thread only */
+  void record(juce::uint64 nanoseconds) {
+    if (resetRequested.exchange(false, std::memory_order_acquire))
+      clear();
+
+    auto &bin = bins[(size_t)getBin(nanoseconds)];
+    bin.store(bin.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sumNs.store(sumNs.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds < minNs.load(std::memory_order_relaxed))
+      minNs.store(nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds > maxNs.load(std::memory_order_relaxed))
+      maxNs.store(nanoseconds, std::memory_order_relaxed);
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /** Any thread: cleared by the writer before its next record() */
+  void reset() { resetRequested.store(true, std::memory_order_release); }
+
+  /** Any thread; may be a record or two out of step while the writer runs */
+  Stats getStats() const {
+    Stats stats;
+    stats.count = count.load(std::memory_order_acquire);
+    if (stats.count == 0)
+      return stats;
+
+    stats.minUs = (double)minNs.load(std::memory_order_relaxed) * 1.0e-3;
+    stats.maxUs = (double)maxNs.load(std::memory_order_relaxed) * 1.0e-3;
+    stats.meanUs = (double)sumNs.load(std::memory_order_relaxed) * 1.0e-3 / (double)stats.count;
+    stats.p99Us = juce::jmin(stats.maxUs, getPercentileUs(0.99));
+    stats.p999Us = juce::jmin(stats.maxUs, getPercentileUs(0.999));
+    return stats;
+  }
+
+  /** Upper edge of the bin holding the given fraction of all records */
+  double getPercentileUs(double fraction) const {
+    juce::uint64 total = 0;
+    std::array<juce::uint64, numBins> counts;
+    for (int i = 0; i < numBins; ++i)
+      total += counts[(size_t)i] = bins[(size_t)i].load(std::memory_order_relaxed);
+
+    const auto target = (juce::uint64)std::ceil(fraction * (double)total);
+    juce::uint64 seen = 0;
+    for (int i = 0; i < numBins; ++i) {
+      seen += counts[(size_t)i];
+      if (seen >= target && seen > 0)
+        return (double)getBinUpperEdge(i) * 1.0e-3;
+    }
+    return 0.0;
+  }
+
+  /** Records per bin, for dumps */
+  juce::uint64 getBinCount(int bin) const { return bins[(size_t)bin].load(std::memory_order_relaxed); }
+  static juce::uint64 getBinUpperEdge(int bin) {
+    if (bin < 8) // bins 4-7 stay empty
+      return (juce::uint64)juce::jmin(bin + 1, 4);
+    const int octave = bin / 4;
+    return (juce::uint64)(5 + bin % 4) << (octave - 2);
+  }
+
+private:
+  // Octave from the highest set bit, quarter octave from the next two
+  static int getBin(juce::uint64 nanoseconds) {
+    const auto ns = (juce::uint32)juce::jmin<juce::uint64>(nanoseconds, 0x7fffffff);
+    if (ns < 4)
+      return (int)ns;
+    const int octave = juce::findHighestSetBit(ns);
+    return octave * 4 + (int)((ns >> (octave - 2)) & 3);
+  }
+
+  void clear() {
+    for (auto &bin : bins)
+      bin.store(0, std::memory_order_relaxed);
+    sumNs.store(0, std::memory_order_relaxed);
+    minNs.store(~juce::uint64(0), std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_release);
+  }
+
+  std::array<std::atomic<juce::uint64>, numBins> bins {};
+  std::atomic<juce::uint64> count { 0 };
+  std::atomic<juce::uint64> sumNs { 0 };
+  std::atomic<juce::uint64> minNs { ~juce::uint64(0) };
+  std::atomic<juce::uint64> maxNs { 0 };
+  std::atomic<bool> resetRequested { false };
+};
+
+/** Timed sections of the live audio callback, in processing order */
+enum class ProfileStage {
+  INPUT,        // transport read into the device buffer
+  DRY_COPY,     // dry delay line write and input meter
+  PRE_FILTERS,  // iron, LF pole, HF resonance, HF roll
+  UPSAMPLE,
+  CORE,         // waveshaper, hysteresis and dynamic allpass
+  DOWNSAMPLE,
+  POST_FILTERS, // post shelf and DC blocker
+  SOFT_LIMIT    // soft limit, wet/dry mix and output meter
+};
+
+/**
+ * Per-stage timings of the audio callback. The audio thread accumulates
+ * each stage's time over one callback (all chunks and channel groups) and
+ * records the total into that stage's LatencyHistogram at the end; the UI
+ * reads the histograms at any time without blocking it.
+ */
+class StageProfiler {
+public:
+  static constexpr int numStages = (int)ProfileStage::SOFT_LIMIT + 1;
+
+  static const char *getStageName(ProfileStage stage) {
+    static const char *const names[numStages] = { "input",        "dry copy",  "pre-filters",
+                                                  "upsample",     "core",      "downsample",
+                                                  "post-filters", "soft limit" };
+    return names[(int)stage];
+  }
+
+  /** Audio thread: bracket one callback */
+  void beginCallback() {
+    pendingTicks.fill(0);
+    ranStages = 0;
+  }
+  void endCallback() {
+    for (int i = 0; i < numStages; ++i)
+      if (ranStages & (1u << i))
+        histograms[(size_t)i].record((juce::uint64)((double)pendingTicks[(size_t)i] * nsPerTick));
+  }
+
+  /** Audio thread: time spent in a stage during the current callback */
+  void addTicks(ProfileStage stage, juce::int64 ticks) {
+    pendingTicks[(size_t)stage] += ticks;
+    ranStages |= 1u << (int)stage;
+  }
+
+  const LatencyHistogram &getHistogram(ProfileStage stage) const {
+    return histograms[(size_t)stage];
+  }
+
+  /** Any thread */
+  void reset() {
+    for (auto &histogram : histograms)
+      histogram.reset();
+  }
+
+  /** One line per stage that ran: min/mean/p99/max in microseconds */
+  juce::String getSummary() const {
+    juce::String summary;
+    summary << "stage          min   mean    p99    max us\n";
+    for (int i = 0; i < numStages; ++i) {
+      const auto stats = histograms[(size_t)i].getStats();
+      if (stats.count == 0)
+        continue;
+      summary << juce::String(getStageName((ProfileStage)i)).paddedRight(' ', 12)
+              << juce::String(stats.minUs, 1).paddedLeft(' ', 6)
+              << juce::String(stats.meanUs, 1).paddedLeft(' ', 7)
+              << juce::String(stats.p99Us, 1).paddedLeft(' ', 7)
+              << juce::String(stats.maxUs, 1).paddedLeft(' ', 7) << "\n";
+    }
+    return summary;
+  }
+
+private:
+  const double nsPerTick = 1.0e9 / (double)juce::Time::getHighResolutionTicksPerSecond();
+  std::array<juce::int64, numStages> pendingTicks {};
+  unsigned ranStages = 0;
+  std::array<LatencyHistogram, numStages> histograms;
+};
+
+/** Adds the enclosing scope's duration to a stage; no-op without a profiler */
+class ScopedStageTimer {
+public:
+  ScopedStageTimer(StageProfiler *profilerToUse, ProfileStage stageToTime)
+      : profiler(profilerToUse), stage(stageToTime),
+        start(profilerToUse != nullptr ? juce::Time::getHighResolutionTicks() : 0) {}
+
+  ~ScopedStageTimer() {
+    if (profiler != nullptr)
+      profiler->addTicks(stage, juce::Time::getHighResolutionTicks() - start);
+  }
+
+private:
+  StageProfiler *profiler;
+  ProfileStage stage;
+  juce::int64 start;
+
+  JUCE_DECLARE_NON_COPYABLE(ScopedStageTimer)
+};
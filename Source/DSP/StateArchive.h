@@ -0,0 +1,110 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Cursor over a caller-owned binary state blob. Each stateful class has one
+ * transferState(archive) that both saves and restores, so the two can never
+ * drift apart; a measuring archive sizes the blob up front. Never allocates.
+ */
+class StateArchive {
+public:
+  enum class Mode { MEASURE, SAVE, RESTORE };
+
+  static StateArchive measure() { return StateArchive(Mode::MEASURE, nullptr, 0); }
+  static StateArchive save(void *data, size_t size) {
+    return StateArchive(Mode::SAVE, static_cast<juce::uint8 *>(data), size);
+  }
+  static StateArchive restore(const void *data, size_t size) {
+    return StateArchive(Mode::RESTORE, static_cast<juce::uint8 *>(const_cast<void *>(data)), size);
+  }
+
+  bool isRestoring() const { return mode == Mode::RESTORE; }
+  /** False once a transfer would run past the end of the blob; later ones are skipped */
+  bool isValid() const { return valid; }
+  size_t getPosition() const { return position; }
+
+  /** Trivially copyable values, as raw bytes */
+  template <typename T>
+  void value(T &item) {
+    items(&item, 1);
+  }
+
+  template <typename T>
+  void items(T *first, size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw bytes only");
+    const size_t bytes = sizeof(T) * count;
+    if (mode != Mode::MEASURE) {
+      if (!valid || position + bytes > size) {
+        valid = false;
+        return;
+      }
+      if (mode == Mode::SAVE)
+        std::memcpy(data + position, first, bytes);
+      else
+        std::memcpy(first, data + position, bytes);
+    }
+    position += bytes;
+  }
+
+private:
+  StateArchive(Mode archiveMode, juce::uint8 *blob, size_t blobSize)
+      : mode(archiveMode), data(blob), size(blobSize) {}
+
+  Mode mode;
+  juce::uint8 *data;
+  size_t size;
+  size_t position = 0;
+  bool valid = true;
+};
+
+/**
+ * juce::LinearSmoothedValue whose ramp can be saved and restored. A restored
+ * ramp resumes from the same value with the same number of steps left; its
+ * step size is recomputed from those, so it matches to within rounding.
+ */
+template <typename FloatType>
+class SmoothedParameter : public juce::LinearSmoothedValue<FloatType> {
+public:
+  using Base = juce::LinearSmoothedValue<FloatType>;
+  using Base::Base;
+  using Base::reset;
+
+  void reset(double sampleRate, double rampLengthInSeconds) {
+    rampSteps = (int)std::floor(rampLengthInSeconds * sampleRate);
+    Base::reset(sampleRate, rampLengthInSeconds);
+  }
+
+  void transferState(StateArchive &archive) {
+    FloatType current = this->currentValue, finalValue = this->target;
+    int remaining = this->countdown;
+    archive.value(current);
+    archive.value(finalValue);
+    archive.value(remaining);
+    if (!archive.isRestoring() || !archive.isValid())
+      return;
+
+    this->setCurrentAndTargetValue(finalValue);
+    if (remaining <= 0 || rampSteps <= 0)
+      return;
+
+    // setTargetValue() derives the step from the ramp length, so ramp over
+    // the remaining steps, then put the configured length back (which keeps
+    // the step but stops the ramp) and resume it
+    remaining = juce::jmin(remaining, rampSteps);
+    Base::reset(remaining);
+    this->setCurrentAndTargetValue(current);
+    this->setTargetValue(finalValue);
+    const bool ramping = this->isSmoothing();
+    Base::reset(rampSteps);
+    if (ramping) {
+      this->currentValue = current;
+      this->countdown = remaining;
+    }
+  }
+
+private:
+  int rampSteps = 0;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "BiquadFilter.h"
+#include "StateArchive.h"
+#include <juce_dsp/juce_dsp.h>
+
+/**
+ * Cascade of trapezoidal state-variable filters (Simper), one channel per
+ * SIMD lane, in either precision. Direct-form biquads with poles at a few
+ * Hz lose most of their accuracy once coefficients are rounded to float,
+ * while the SVF's integrator states keep low-frequency sections within
+ * about -130 dB of the double design.
+ */
+template <size_t NumStages, typename SampleType = float>
+class SvfCascade {
+public:
+  using Vec = juce::dsp::SIMDRegister<SampleType>;
+  static constexpr size_t numLanes = Vec::SIMDNumElements;
+
+  SvfCascade() { reset(); }
+
+  void reset() {
+    for (size_t s = 0; s < NumStages; ++s)
+      ic1[s] = ic2[s] = Vec::expand(SampleType(0.0));
+  }
+
+  // All lanes share the same design
+  void setStage(size_t stage, const BiquadFilter &design) {
+    setStage(stage, design.getSvfCoefficients());
+  }
+
+  void setStage(size_t stage, const BiquadFilter::SvfCoefficients &c) {
+    jassert(stage < NumStages);
+    const double g1 = 1.0 / (1.0 + c.g * (c.g + c.k));
+    a1[stage] = Vec::expand(static_cast<SampleType>(g1));
+    a2[stage] = Vec::expand(static_cast<SampleType>(c.g * g1));
+    a3[stage] = Vec::expand(static_cast<SampleType>(c.g * c.g * g1));
+    m0[stage] = Vec::expand(static_cast<SampleType>(c.m0));
+    m1[stage] = Vec::expand(static_cast<SampleType>(c.m1));
+    m2[stage] = Vec::expand(static_cast<SampleType>(c.m2));
+  }
+
+  /** True when every integrator state is below threshold in magnitude */
+  bool isQuiet(SampleType threshold) const {
+    for (size_t s = 0; s < NumStages; ++s)
+      for (size_t lane = 0; lane < numLanes; ++lane)
+        if (std::abs(ic1[s].get(lane)) >= threshold || std::abs(ic2[s].get(lane)) >= threshold)
+          return false;
+    return true;
+  }
+
+  /** Integrator states and the current coefficients, which move with ramps */
+  void transferState(StateArchive &archive) {
+    for (auto *vecs : { a1, a2, a3, m0, m1, m2, ic1, ic2 })
+      archive.items(vecs, NumStages);
+  }
+
+  inline Vec processFrame(Vec x) { return tick(x, ic1, ic2); }
+
+  // In-place over interleaved frames (one Vec per sample frame)
+  void process(Vec *frames, int numFrames) {
+    // Work on local copies so the state stays in registers across the loop
+    Vec s1[NumStages], s2[NumStages];
+    for (size_t s = 0; s < NumStages; ++s) {
+      s1[s] = ic1[s];
+      s2[s] = ic2[s];
+    }
+
+    for (int i = 0; i < numFrames; ++i)
+      frames[i] = tick(frames[i], s1, s2);
+
+    for (size_t s = 0; s < NumStages; ++s) {
+      ic1[s] = s1[s];
+      ic2[s] = s2[s];
+    }
+  }
+
+private:
+  inline Vec tick(Vec x, Vec *s1, Vec *s2) const {
+    const Vec two = Vec::expand(SampleType(2.0));
+    const Vec threshold = Vec::expand(SampleType(1e-15));
+    const Vec negThreshold = Vec::expand(SampleType(-1e-15));
+
+    for (size_t s = 0; s < NumStages; ++s) {
+      Vec v3 = x - s2[s];
+      Vec band = a1[s] * s1[s] + a2[s] * v3;
+      Vec low = s2[s] + a2[s] * s1[s] + a3[s] * v3;
+      Vec n1 = two * band - s1[s];
+      Vec n2 = two * low - s2[s];
+      // Flush denormals to zero
+      s1[s] = n1 & (Vec::greaterThan(n1, threshold) | Vec::lessThan(n1, negThreshold));
+      s2[s] = n2 & (Vec::greaterThan(n2, threshold) | Vec::lessThan(n2, negThreshold));
+      x = m0[s] * x + m1[s] * band + m2[s] * low;
+    }
+    return x;
+  }
+
+  Vec a1[NumStages], a2[NumStages], a3[NumStages];
+  Vec m0[NumStages], m1[NumStages], m2[NumStages];
+  Vec ic1[NumStages], ic2[NumStages];
+};
@@ -1,50 +1,233 @@
 #pragma once
 
+#include "StateArchive.h"
+#include <array>
 #include <cmath>
 #include <juce_audio_basics/juce_audio_basics.h>
 
+/** Waveshaper evaluation mode, see Waveshaper */
+enum class WaveshaperMode { FAST, REFERENCE, ADAA };
+
+/**
+ * Antiderivative of the positive half of the curve, G(v) = integral of
+ * tanh(1.5 s + 0.3 s^3) over [0, v], at 128 nodes per unit up to v = 3.5
+ * (where tanh has saturated to 1 within 1e-15). Cubic Hermite between
+ * nodes with the exact slope keeps difference quotients within 2e-8.
+ */
+struct WaveshaperAntiderivative {
+  static constexpr int nodesPerUnit = 128;
+  static constexpr double maxInput = 3.5;
+  static constexpr int numNodes = (int)(maxInput * nodesPerUnit) + 1;
+
+  WaveshaperAntiderivative() {
+    // 4-point Gauss-Legendre on eighths of each cell
+    static const double gx[] = { -0.8611363115940526, -0.3399810435848563,
+                                 0.3399810435848563, 0.8611363115940526 };
+    static const double gw[] = { 0.3478548451374538, 0.6521451548625461,
+                                 0.6521451548625461, 0.3478548451374538 };
+    const double h = 1.0 / nodesPerUnit;
+    value[0] = 0.0;
+    for (int i = 0; i < numNodes; ++i) {
+      slope[(size_t)i] = curve(i * h);
+      if (i == 0)
+        continue;
+      double sum = 0.0;
+      for (int k = 0; k < 8; ++k) {
+        double mid = (i - 1 + (k + 0.5) / 8.0) * h, half = 0.5 * h / 8.0;
+        for (int g = 0; g < 4; ++g)
+          sum += gw[g] * curve(mid + half * gx[g]) * half;
+      }
+      value[(size_t)i] = value[(size_t)i - 1] + sum;
+    }
+  }
+
+  static double curve(double v) { return std::tanh(v * (1.5 + 0.3 * v * v)); }
+
+  double evaluate(double v) const {
+    // Beyond the table the curve is flat at 1, so G grows linearly
+    double beyond = juce::jmax(0.0, v - maxInput);
+    double pos = juce::jmin(v, maxInput) * nodesPerUnit;
+    int i = juce::jmin((int)pos, numNodes - 2);
+    double t = pos - i, t2 = t * t, t3 = t2 * t;
+    const double h = 1.0 / nodesPerUnit;
+    auto idx = (size_t)i;
+    return value[idx] * (2.0 * t3 - 3.0 * t2 + 1.0) + h * slope[idx] * (t3 - 2.0 * t2 + t) +
+           value[idx + 1] * (3.0 * t2 - 2.0 * t3) + h * slope[idx + 1] * (t3 - t2) + beyond;
+  }
+
+  std::array<double, numNodes> value {};
+  std::array<double, numNodes> slope {};
+
+  static const WaveshaperAntiderivative &get() {
+    static const WaveshaperAntiderivative table;
+    return table;
+  }
+};
+
 /**
  * Transformer saturation waveshaper
  * Asymmetric tanh-based transfer function with 3rd harmonic bias.
  * Output gain-compensated to maintain unity at small signal levels.
+ *
+ * FAST mode (default) evaluates a branch-free rational tanh approximation
+ * that vectorises over whole blocks; REFERENCE mode keeps the original
+ * std::tanh path for A/B comparison and golden renders. ADAA mode applies
+ * first-order antiderivative anti-aliasing so lower oversampling factors
+ * reach the same alias rejection, at the cost of half a sample of delay
+ * and a gentle (1 + z^-1) / 2 droop at the processing rate.
+ *
+ * Templated on the sample type; the ADAA quotient is always formed in double
+ * because float cancellation would swamp it.
  */
+template <typename SampleType>
 class Waveshaper {
 public:
-  Waveshaper() { setDrive(0.5); }
+  using Mode = WaveshaperMode;
+
+  Waveshaper() : antiderivativeTable(&WaveshaperAntiderivative::get()) { setDrive(0.5); }
 
   void setDrive(double driveAmount) {
     drive = juce::jlimit(0.0, 1.0, driveAmount);
-    inputScale = 1.0 + drive * 3.0; // 1.0 to 4.0 range
-    outputGain = 1.0 / (1.5 * inputScale);
+    inputScale = static_cast<SampleType>(1.0 + drive * 3.0); // 1.0 to 4.0 range
+    outputGain = static_cast<SampleType>(1.0 / (1.5 * (1.0 + drive * 3.0)));
+  }
+
+  void setMode(Mode newMode) {
+    if (newMode != mode)
+      reset();
+    mode = newMode;
+  }
+  Mode getMode() const { return mode; }
+
+  void reset() {
+    prevU = 0.0;
+    prevF = 0.0;
   }
 
-  void reset() {}
+  void transferState(StateArchive &archive) {
+    archive.value(mode);
+    archive.value(drive);
+    archive.value(prevU);
+    archive.value(prevF);
+    if (archive.isRestoring())
+      setDrive(drive);
+  }
+
+  inline SampleType process(SampleType input) {
+    SampleType x = input * inputScale;
+    if (mode == Mode::REFERENCE)
+      return transferFunction(x) * outputGain;
+    if (mode == Mode::ADAA)
+      return static_cast<SampleType>(antialiasedTransfer(x, 1.5 * inputScale));
+    return fastTransfer(x, SampleType(1.5) * inputScale);
+  }
+
+  inline SampleType processWithHysteresis(SampleType input, SampleType coreState, int /*channel*/) {
+    SampleType scale = SampleType(1.0) + SampleType(0.2) * coreState;
+    SampleType x = input * inputScale * scale;
+    if (mode == Mode::REFERENCE) {
+      SampleType normGain = SampleType(1.0) / (SampleType(1.5) * inputScale * scale);
+      return transferFunction(x) * normGain;
+    }
+    if (mode == Mode::ADAA)
+      return static_cast<SampleType>(antialiasedTransfer(x, 1.5 * inputScale * scale));
+    return fastTransfer(x, SampleType(1.5) * inputScale * scale);
+  }
 
-  inline double process(double input) {
-    double x = input * inputScale;
-    return transferFunction(x) * outputGain;
+  /** Block form of processWithHysteresis, one coreState per sample, in place */
+  void processBlock(SampleType *samples, const SampleType *coreState, int numSamples) {
+    if (mode == Mode::ADAA) {
+      for (int i = 0; i < numSamples; ++i)
+        samples[i] = processWithHysteresis(samples[i], coreState[i], 0);
+      return;
+    }
+    if (mode == Mode::REFERENCE) {
+      for (int i = 0; i < numSamples; ++i) {
+        SampleType scale = SampleType(1.0) + SampleType(0.2) * coreState[i];
+        samples[i] = transferFunction(samples[i] * inputScale * scale) /
+                     (SampleType(1.5) * inputScale * scale);
+      }
+      return;
+    }
+
+    const SampleType scaleIn = inputScale;
+    for (int i = 0; i < numSamples; ++i) {
+      SampleType scale = SampleType(1.0) + SampleType(0.2) * coreState[i];
+      samples[i] = fastTransfer(samples[i] * scaleIn * scale, SampleType(1.5) * scaleIn * scale);
+    }
   }
 
-  inline double processWithHysteresis(double input, double coreState, int /*channel*/) {
-    double scale = 1.0 + 0.2 * coreState;
-    double x = input * inputScale * scale;
-    double normGain = 1.0 / (1.5 * inputScale * scale);
-    return transferFunction(x) * normGain;
+  /**
+   * tanh(x) / divisor as a [9/8] rational (Lambert continued fraction).
+   * The argument is clamped to +-6.25, below where the fraction reaches 1,
+   * so the result stays in (-1, 1). Max |error| vs std::tanh over the whole
+   * real line is 6.3e-6 (about -104 dB), at the clamp point.
+   */
+  static inline SampleType fastTanh(SampleType x, SampleType divisor = SampleType(1.0)) {
+    x = juce::jlimit(SampleType(-6.25), SampleType(6.25), x);
+    SampleType x2 = x * x;
+    SampleType p = x * (SampleType(34459425.0) +
+                        x2 * (SampleType(4729725.0) +
+                              x2 * (SampleType(135135.0) + x2 * (SampleType(990.0) + x2))));
+    SampleType q = SampleType(34459425.0) +
+                   x2 * (SampleType(16216200.0) +
+                         x2 * (SampleType(945945.0) +
+                               x2 * (SampleType(13860.0) + x2 * SampleType(45.0))));
+    return p / (q * divisor);
   }
 
 private:
-  inline double transferFunction(double x) const {
-    if (x >= 0.0) {
-      double x3 = x * x * x;
-      return std::tanh(1.5 * x + 0.3 * x3);
+  inline SampleType transferFunction(SampleType x) const {
+    if (x >= SampleType(0.0)) {
+      SampleType x3 = x * x * x;
+      return std::tanh(SampleType(1.5) * x + SampleType(0.3) * x3);
     } else {
-      double xNeg = -x * 0.95;
-      double xNeg3 = xNeg * xNeg * xNeg;
-      return -std::tanh(1.5 * xNeg + 0.3 * xNeg3);
+      SampleType xNeg = -x * SampleType(0.95);
+      SampleType xNeg3 = xNeg * xNeg * xNeg;
+      return -std::tanh(SampleType(1.5) * xNeg + SampleType(0.3) * xNeg3);
     }
   }
 
+  // Same curve as transferFunction, divided by normDivisor. tanh is odd, so
+  // the negative branch is just a 0.95 input scale; the select compiles to a
+  // blend and the normalising division folds into the rational's own.
+  static inline SampleType fastTransfer(SampleType x, SampleType normDivisor) {
+    SampleType xs = x * (x >= SampleType(0.0) ? SampleType(1.0) : SampleType(0.95));
+    return fastTanh(xs * (SampleType(1.5) + SampleType(0.3) * xs * xs), normDivisor);
+  }
+
+  // Antiderivative of the full asymmetric curve; the negative half is the
+  // positive one scaled by 0.95, so F(u) = G(0.95 |u|) / 0.95 for u < 0
+  inline double antiderivative(double u) const {
+    bool positive = u >= 0.0;
+    double v = std::abs(u) * (positive ? 1.0 : 0.95);
+    return antiderivativeTable->evaluate(v) * (positive ? 1.0 : 1.0 / 0.95);
+  }
+
+  // First-order ADAA, divided by normDivisor: mean of the curve over the
+  // segment since the previous sample, falling back to the midpoint value
+  // when the segment is too short for the quotient to be well conditioned
+  inline double antialiasedTransfer(double u, double normDivisor) {
+    double f = antiderivative(u);
+    double du = u - prevU;
+    double y = std::abs(du) > 1.0e-5 ? (f - prevF) / (du * normDivisor)
+                                      : Waveshaper<double>::fastTransfer(0.5 * (u + prevU), normDivisor);
+    prevU = u;
+    prevF = f;
+    return y;
+  }
+
+  template <typename> friend class Waveshaper;
+
+  const WaveshaperAntiderivative *antiderivativeTable; // built once, off the audio thread
+
+  Mode mode = Mode::FAST;
   double drive = 0.5;
-  double inputScale = 2.0;
-  double outputGain = 1.0 / (1.5 * 2.0);
+  SampleType inputScale = SampleType(2.0);
+  SampleType outputGain = SampleType(1.0 / (1.5 * 2.0));
+
+  // ADAA state (double in every instantiation): previous scaled input and
+  // its antiderivative
+  double prevU = 0.0;
+  double prevF = 0.0;
 };
@@ -0,0 +1,166 @@
+#include "BatchRenderer.h"
+
+class BatchRenderer::RenderJob : public juce::ThreadPoolJob {
+public:
+  RenderJob(BatchRenderer &ownerRef, JobState &stateRef)
+      : juce::ThreadPoolJob("Render " + stateRef.item.input.getFileName()),
+        owner(ownerRef), state(stateRef) {}
+
+  JobStatus runJob() override {
+    RenderResult result;
+    result.inputFile = state.item.input;
+    result.outputFile = state.item.output;
+    result.error = "Cancelled";
+
+    if (!owner.cancelled.load(std::memory_order_relaxed)) {
+      OfflineRenderer renderer(owner.formatManager);
+      result = renderer.render(
+          state.item.input, state.item.output, owner.settings,
+          [this](double p) { state.progress.store(p, std::memory_order_relaxed); },
+          [this] { return shouldExit() || owner.cancelled.load(std::memory_order_relaxed); });
+    }
+
+    {
+      const juce::ScopedLock sl(owner.resultLock);
+      state.result = result;
+    }
+
+    owner.jobFinished(state);
+    return jobHasFinished;
+  }
+
+private:
+  BatchRenderer &owner;
+  JobState &state;
+};
+
+BatchRenderer::BatchRenderer(juce::AudioFormatManager &formats, int threads)
+    : formatManager(formats),
+      numThreads(juce::jmax(1, threads)),
+      pool(numThreads) {}
+
+BatchRenderer::~BatchRenderer() {
+  cancel();
+  pool.removeAllJobs(true, -1);
+}
+
+bool BatchRenderer::start(const juce::Array<Item> &items,
+                          const RenderSettings &newSettings) {
+  if (isRunning() || items.isEmpty())
+    return false;
+
+  settings = newSettings;
+  jobs.clear();
+  for (const auto &item : items) {
+    auto state = std::make_unique<JobState>();
+    state->item = item;
+    state->result.inputFile = item.input;
+    state->result.outputFile = item.output;
+    jobs.push_back(std::move(state));
+  }
+
+  cancelled.store(false, std::memory_order_relaxed);
+  finishedJobs.store(0, std::memory_order_relaxed);
+  renderedAudioSeconds.store(0.0, std::memory_order_relaxed);
+  endTimeMs.store(0.0, std::memory_order_relaxed);
+  startTimeMs = juce::Time::getMillisecondCounterHiRes();
+  finishedEvent.reset();
+  running.store(true, std::memory_order_release);
+
+  for (auto &state : jobs)
+    pool.addJob(new RenderJob(*this, *state), true);
+
+  return true;
+}
+
+void BatchRenderer::cancel() {
+  // Running jobs stop at their next block; pending ones finish immediately
+  // as "Cancelled" when the pool picks them up.
+  cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool BatchRenderer::waitForCompletion(int timeoutMs) {
+  return finishedEvent.wait(timeoutMs);
+}
+
+void BatchRenderer::jobFinished(JobState &state) {
+  state.progress.store(1.0, std::memory_order_relaxed);
+
+  if (state.result.samplesProcessed > 0) {
+    auto seconds = state.result.getAudioSeconds();
+    auto current = renderedAudioSeconds.load(std::memory_order_relaxed);
+    while (!renderedAudioSeconds.compare_exchange_weak(current, current + seconds,
+                                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  if (onJobFinished)
+    onJobFinished(state.result);
+
+  if (finishedJobs.fetch_add(1, std::memory_order_acq_rel) + 1 == getNumJobs()) {
+    endTimeMs.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+    running.store(false, std::memory_order_release);
+    finishedEvent.signal();
+    if (onBatchFinished)
+      onBatchFinished();
+  }
+}
+
+double BatchRenderer::getJobProgress(int index) const {
+  if (!juce::isPositiveAndBelow(index, getNumJobs()))
+    return 0.0;
+  return jobs[(size_t)index]->progress.load(std::memory_order_relaxed);
+}
+
+double BatchRenderer::getTotalProgress() const {
+  if (jobs.empty())
+    return 0.0;
+
+  double sum = 0.0;
+  for (const auto &state : jobs)
+    sum += state->progress.load(std::memory_order_relaxed);
+  return sum / (double)jobs.size();
+}
+
+double BatchRenderer::getElapsedSeconds() const {
+  if (startTimeMs <= 0.0)
+    return 0.0;
+  auto end = endTimeMs.load(std::memory_order_relaxed);
+  if (end <= 0.0)
+    end = juce::Time::getMillisecondCounterHiRes();
+  return (end - startTimeMs) / 1000.0;
+}
+
+double BatchRenderer::getRenderedAudioSeconds() const {
+  return renderedAudioSeconds.load(std::memory_order_relaxed);
+}
+
+double BatchRenderer::getRealtimeFactor() const {
+  auto elapsed = getElapsedSeconds();
+  return elapsed > 0.0 ? getRenderedAudioSeconds() / elapsed : 0.0;
+}
+
+juce::Array<RenderResult> BatchRenderer::getResults() const {
+  const juce::ScopedLock sl(resultLock);
+  juce::Array<RenderResult> results;
+  for (const auto &state : jobs)
+    results.add(state->result);
+  return results;
+}
+
+juce::Array<juce::File>
+BatchRenderer::collectAudioFiles(const juce::Array<juce::File> &filesOrFolders) {
+  juce::Array<juce::File> files;
+  for (const auto &f : filesOrFolders) {
+    if (f.isDirectory()) {
+      auto children = f.findChildFiles(juce::File::findFiles, false, "*.wav;*.aiff;*.aif");
+      children.sort();
+      for (const auto &child : children)
+        if (!child.getFileNameWithoutExtension().endsWith(outputSuffix))
+          files.addIfNotAlreadyThere(child);
+    } else if (f.existsAsFile()) {
+      files.addIfNotAlreadyThere(f);
+    }
+  }
+  return files;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "OfflineRenderer.h"
+#include <atomic>
+#include <vector>
+
+/**
+ * Renders a list of files concurrently on a fixed-size thread pool.
+ * Each job owns its own NeveTransformerDSP instance (via OfflineRenderer),
+ * so jobs share nothing but the read-only settings.
+ */
+class BatchRenderer {
+public:
+  struct Item {
+    juce::File input;
+    juce::File output;
+  };
+
+  // Called from worker threads - marshal to the message thread if needed
+  std::function<void(const RenderResult &)> onJobFinished;
+  std::function<void()> onBatchFinished;
+
+  BatchRenderer(juce::AudioFormatManager &formats, int numThreads);
+  ~BatchRenderer();
+
+  // Queues all items and starts rendering. Ignored while a batch is running.
+  bool start(const juce::Array<Item> &items, const RenderSettings &settings);
+
+  // Stops running jobs at the next block boundary and drops pending ones
+  void cancel();
+  bool waitForCompletion(int timeoutMs = -1);
+
+  bool isRunning() const { return running.load(std::memory_order_acquire); }
+  int getNumThreads() const { return numThreads; }
+  int getNumJobs() const { return (int)jobs.size(); }
+  int getNumFinishedJobs() const { return finishedJobs.load(std::memory_order_acquire); }
+
+  double getJobProgress(int index) const;
+  double getTotalProgress() const;
+
+  // Summed audio duration of finished jobs divided by batch wall time
+  double getRealtimeFactor() const;
+  double getElapsedSeconds() const;
+  double getRenderedAudioSeconds() const;
+
+  // Only complete once the batch has finished
+  juce::Array<RenderResult> getResults() const;
+
+  // Appended to the input name by NeveRender's output files
+  static constexpr const char *outputSuffix = "_neve";
+
+  // Collects the audio files from a mix of files and folders (non-recursive),
+  // skipping earlier renders (outputSuffix) found in folders and repeats
+  static juce::Array<juce::File> collectAudioFiles(const juce::Array<juce::File> &filesOrFolders);
+
+private:
+  class RenderJob;
+
+  struct JobState {
+    Item item;
+    std::atomic<double> progress { 0.0 };
+    RenderResult result;
+  };
+
+  void jobFinished(JobState &state);
+
+  juce::AudioFormatManager &formatManager;
+  const int numThreads;
+  juce::ThreadPool pool;
+
+  RenderSettings settings;
+  std::vector<std::unique_ptr<JobState>> jobs;
+
+  std::atomic<bool> running { false };
+  std::atomic<bool> cancelled { false };
+  std::atomic<int> finishedJobs { 0 };
+
+  double startTimeMs = 0.0;
+  std::atomic<double> endTimeMs { 0.0 };
+  std::atomic<double> renderedAudioSeconds { 0.0 };
+
+  juce::CriticalSection resultLock;
+  juce::WaitableEvent finishedEvent { true };
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchRenderer)
+};
@@ -0,0 +1,289 @@
+#include "OfflineRenderer.h"
+#include "SegmentedRenderer.h"
+
+namespace {
+
+template <typename Engine>
+std::unique_ptr<Engine> createEngine(double sampleRate, int numChannels,
+                                     const RenderSettings &settings) {
+  auto engine = std::make_unique<Engine>();
+  engine->setOversamplingFactor(settings.oversampling);
+  engine->setOversamplingFilter(settings.oversamplingFilter);
+  // The engine chunks longer reads through its own buffers, so its memory
+  // stays fixed however large the read block is
+  engine->prepare(sampleRate, juce::jlimit(1, 4096, settings.blockSize), numChannels);
+  settings.applyTo(*engine);
+  return engine;
+}
+
+// One block of the export pipeline, recycled from writer back to reader
+struct PipelineBlock {
+  juce::AudioBuffer<float> audio;
+  int numSamples = 0;
+};
+
+// Room for every block plus the end of stream marker (nullptr); AbstractFifo
+// keeps one slot free
+using BlockQueue = SpscQueue<PipelineBlock *, OfflineRenderer::pipelineDepth + 2>;
+
+// Next block for a consumer stage, sleeping until its producer signals;
+// false once the pipeline has been aborted and nothing is queued
+bool popBlock(BlockQueue &queue, juce::WaitableEvent &wakeup, const std::atomic<bool> &aborted,
+              PipelineBlock *&block) {
+  for (;;) {
+    if (auto *item = queue.peek()) {
+      block = *item;
+      queue.pop();
+      return true;
+    }
+    if (aborted.load(std::memory_order_acquire))
+      return false;
+    wakeup.wait(5);
+  }
+}
+
+void pushBlock(BlockQueue &queue, juce::WaitableEvent &wakeup, PipelineBlock *block) {
+  const bool queued = queue.push(block);
+  jassert(queued); // Every block plus the end marker always fits
+  juce::ignoreUnused(queued);
+  wakeup.signal();
+}
+
+} // namespace
+
+std::unique_ptr<juce::AudioFormatReader>
+OfflineRenderer::createReaderFor(juce::AudioFormatManager &formats, const juce::File &input) {
+  std::unique_ptr<juce::AudioFormat> format;
+  auto ext = input.getFileExtension().toLowerCase();
+  if (ext == ".wav")
+    format = std::make_unique<juce::WavAudioFormat>();
+  else if (ext == ".aiff" || ext == ".aif")
+    format = std::make_unique<juce::AiffAudioFormat>();
+
+  // Compressed or unusual encodings have no mapped reader
+  if (format != nullptr) {
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(
+        format->createMemoryMappedReader(input));
+    if (mapped != nullptr && mapped->mapEntireFile())
+      return mapped;
+  }
+
+  return std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(input));
+}
+
+juce::String RenderResult::toJSON() const {
+  auto *obj = new juce::DynamicObject();
+  obj->setProperty("file", inputFile.getFullPathName());
+  obj->setProperty("output", outputFile.getFullPathName());
+  obj->setProperty("ok", succeeded);
+  if (error.isNotEmpty())
+    obj->setProperty("error", error);
+  obj->setProperty("samples", samplesProcessed);
+  obj->setProperty("totalSamples", totalSamples);
+  obj->setProperty("sampleRate", sampleRate);
+  obj->setProperty("channels", numChannels);
+  obj->setProperty("audioSeconds", getAudioSeconds());
+  obj->setProperty("wallSeconds", wallSeconds);
+  obj->setProperty("xRealtime", getRealtimeFactor());
+  if (numSegments > 1) {
+    obj->setProperty("segments", numSegments);
+    obj->setProperty("maxSegmentDeviation", maxSegmentDeviation);
+  }
+  return juce::JSON::toString(juce::var(obj), true);
+}
+
+RenderChain::RenderChain(double sampleRate, int numChannels,
+                         const RenderSettings &settings) {
+  if (settings.doublePrecision)
+    dsp = createEngine<NeveTransformerDSP>(sampleRate, numChannels, settings);
+  else
+    dspFloat = createEngine<NeveTransformerDSPFloat>(sampleRate, numChannels, settings);
+}
+
+void RenderChain::process(juce::AudioBuffer<float> &buffer) {
+  if (dsp != nullptr)
+    dsp->processBlock(buffer);
+  else
+    dspFloat->processBlock(buffer);
+}
+
+int RenderChain::getLatencySamples() const {
+  return dsp != nullptr ? dsp->getLatencySamples() : dspFloat->getLatencySamples();
+}
+
+OfflineRenderer::OfflineRenderer(juce::AudioFormatManager &formats)
+    : formatManager(formats) {}
+
+juce::String OfflineRenderer::getOutputExtensionFor(const juce::File &input) {
+  juce::String ext = input.getFileExtension().toLowerCase();
+  if (ext != ".aiff" && ext != ".aif")
+    ext = ".wav";
+  return ext;
+}
+
+std::unique_ptr<juce::AudioFormatWriter>
+OfflineRenderer::createWriterFor(const juce::File &output, double sampleRate,
+                                 int numChannels, int bitsPerSample,
+                                 juce::String &error) {
+  if (output.existsAsFile())
+    output.deleteFile();
+
+  // Choose format based on extension
+  std::unique_ptr<juce::AudioFormat> format;
+  auto ext = output.getFileExtension().toLowerCase();
+  if (ext == ".aiff" || ext == ".aif")
+    format = std::make_unique<juce::AiffAudioFormat>();
+  else
+    format = std::make_unique<juce::WavAudioFormat>();
+
+  auto *outStream = output.createOutputStream(writeBufferBytes).release();
+
+  if (outStream == nullptr) {
+    error = "Could not create output stream";
+    return nullptr;
+  }
+
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      format->createWriterFor(outStream,
+                              sampleRate,
+                              (unsigned int)numChannels,
+                              (unsigned int)bitsPerSample,
+                              {},
+                              0));
+
+  if (writer == nullptr) {
+    delete outStream;
+    error = "Could not create output writer";
+  }
+
+  return writer;
+}
+
+RenderResult OfflineRenderer::render(const juce::File &input,
+                                     const juce::File &output,
+                                     const RenderSettings &settings,
+                                     ProgressCallback onProgress,
+                                     CancelCallback shouldCancel) const {
+  if (settings.maxSegments > 1)
+    return SegmentedRenderer(formatManager).render(input, output, settings,
+                                                   onProgress, shouldCancel);
+
+  RenderResult result;
+  result.inputFile = input;
+  result.outputFile = output;
+
+  auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+  auto reader = createReaderFor(formatManager, input);
+
+  if (reader == nullptr) {
+    result.error = "Could not read input file";
+    return result;
+  }
+
+  result.totalSamples = reader->lengthInSamples;
+  result.sampleRate = reader->sampleRate;
+  result.numChannels = (int)reader->numChannels;
+
+  auto writer = createWriterFor(output, reader->sampleRate, (int)reader->numChannels,
+                                (int)reader->bitsPerSample, result.error);
+  if (writer == nullptr)
+    return result;
+
+  const int blockSize = juce::jmax(1, settings.blockSize);
+  const juce::int64 length = reader->lengthInSamples;
+
+  const int numChannels = (int)reader->numChannels;
+  RenderChain chain(reader->sampleRate, numChannels, settings);
+
+  // Every block starts out free; the stages pass them reader -> DSP -> writer
+  // and back without allocating
+  std::vector<PipelineBlock> blocks((size_t)pipelineDepth);
+  BlockQueue freeBlocks, readBlocks, processedBlocks;
+  juce::WaitableEvent readerWakeup, processWakeup, writerWakeup;
+  for (auto &block : blocks) {
+    block.audio.setSize(numChannels, blockSize);
+    freeBlocks.push(&block);
+  }
+
+  std::atomic<bool> aborted { false };
+  std::atomic<juce::int64> samplesWritten { 0 };
+  std::atomic<int> remaining { 2 };
+  juce::WaitableEvent stagesDone;
+  juce::String readError, writeError;
+
+  auto finishStage = [&] {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      stagesDone.signal();
+  };
+
+  {
+    juce::ThreadPool pool(2);
+
+    pool.addJob([&] {
+      const bool hasRight = numChannels > 1;
+      PipelineBlock *block = nullptr;
+      for (juce::int64 pos = 0; pos < length && !aborted.load(std::memory_order_acquire) &&
+                                popBlock(freeBlocks, readerWakeup, aborted, block);) {
+        block->numSamples = (int)juce::jmin((juce::int64)blockSize, length - pos);
+        block->audio.setSize(numChannels, block->numSamples, false, false, true);
+        if (!reader->read(&block->audio, 0, block->numSamples, pos, true, hasRight)) {
+          readError = "Read failure at sample " + juce::String(pos);
+          aborted.store(true, std::memory_order_release);
+          break;
+        }
+        pos += block->numSamples;
+        pushBlock(readBlocks, processWakeup, block);
+      }
+      pushBlock(readBlocks, processWakeup, nullptr);
+      finishStage();
+    });
+
+    pool.addJob([&] {
+      PipelineBlock *block = nullptr;
+      while (popBlock(processedBlocks, writerWakeup, aborted, block) && block != nullptr) {
+        if (!writer->writeFromAudioSampleBuffer(block->audio, 0, block->numSamples)) {
+          writeError = "Failed to write output";
+          aborted.store(true, std::memory_order_release);
+          break;
+        }
+        samplesWritten.fetch_add(block->numSamples, std::memory_order_relaxed);
+        pushBlock(freeBlocks, readerWakeup, block);
+      }
+      finishStage();
+    });
+
+    // DSP on this thread
+    PipelineBlock *block = nullptr;
+    while (!aborted.load(std::memory_order_acquire) &&
+           popBlock(readBlocks, processWakeup, aborted, block) && block != nullptr) {
+      if (shouldCancel && shouldCancel()) {
+        result.error = "Cancelled";
+        aborted.store(true, std::memory_order_release);
+        break;
+      }
+
+      chain.process(block->audio);
+      pushBlock(processedBlocks, writerWakeup, block);
+
+      if (onProgress)
+        onProgress((double)samplesWritten.load(std::memory_order_relaxed) / (double)length);
+    }
+    pushBlock(processedBlocks, writerWakeup, nullptr);
+
+    stagesDone.wait();
+  }
+
+  // Flushes whatever is still buffered behind the writer
+  writer.reset();
+
+  if (result.error.isEmpty())
+    result.error = readError.isNotEmpty() ? readError : writeError;
+  if (result.error.isEmpty() && onProgress)
+    onProgress(1.0);
+
+  result.samplesProcessed = samplesWritten.load();
+  result.succeeded = result.error.isEmpty();
+  result.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+  return result;
+}
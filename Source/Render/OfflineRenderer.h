@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../DSP/NeveTransformerDSP.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <functional>
+
+/**
+ * Parameter set for an offline render (mirrors the GUI controls)
+ */
+struct RenderSettings {
+  double drive = 0.3;
+  double iron = 0.5;
+  double hfRoll = 0.7;
+  float mix = 1.0f;
+  bool micMode = false;
+  bool hiZLoad = true;
+  bool bypassed = false;
+  WaveshaperMode shaperMode = WaveshaperMode::FAST;
+  // Applied when the chain is prepared: 1x-16x, FIR (linear phase) or IIR
+  int oversampling = 4;
+  OversamplingFilter oversamplingFilter = OversamplingFilter::FIR;
+  // Double-precision engine (mastering reference) or the float engine
+  bool doublePrecision = true;
+  int blockSize = 4096;
+
+  // Long files are split into up to this many time segments rendered in
+  // parallel (see SegmentedRenderer); 1 renders serially.
+  int maxSegments = 1;
+  double preRollSeconds = 1.0;
+
+  template <typename Engine>
+  void applyTo(Engine &dsp) const {
+    dsp.setDrive(drive);
+    dsp.setIron(iron);
+    dsp.setHFRoll(hfRoll);
+    dsp.setMode(micMode);
+    dsp.setZLoad(hiZLoad);
+    dsp.setBypassed(bypassed);
+    dsp.setWaveshaperMode(shaperMode);
+    dsp.setMix(mix);
+  }
+
+  // Same rendered audio: block size and segmenting leave the sound alone
+  bool soundsSameAs(const RenderSettings &other) const {
+    return drive == other.drive && iron == other.iron && hfRoll == other.hfRoll &&
+           mix == other.mix && micMode == other.micMode && hiZLoad == other.hiZLoad &&
+           bypassed == other.bypassed && shaperMode == other.shaperMode &&
+           oversampling == other.oversampling && oversamplingFilter == other.oversamplingFilter &&
+           doublePrecision == other.doublePrecision;
+  }
+};
+
+/**
+ * Outcome and throughput figures of one rendered file
+ */
+struct RenderResult {
+  bool succeeded = false;
+  juce::String error;
+  juce::File inputFile;
+  juce::File outputFile;
+  juce::int64 samplesProcessed = 0;
+  juce::int64 totalSamples = 0;
+  double sampleRate = 0.0;
+  int numChannels = 0;
+  double wallSeconds = 0.0;
+
+  // Segmented renders: segment count and the largest sample difference
+  // between adjacent segments where they overlap, an estimate of the
+  // boundary mismatch rather than a comparison with a serial render (0 for
+  // serial renders)
+  int numSegments = 1;
+  double maxSegmentDeviation = 0.0;
+
+  double getAudioSeconds() const {
+    return sampleRate > 0.0 ? (double)samplesProcessed / sampleRate : 0.0;
+  }
+
+  double getRealtimeFactor() const {
+    return wallSeconds > 0.0 ? getAudioSeconds() / wallSeconds : 0.0;
+  }
+
+  // Single-line JSON object for machine-readable logs
+  juce::String toJSON() const;
+};
+
+/**
+ * One DSP instance (which also applies the latency-aligned wet/dry mix),
+ * processing a stream block by block
+ */
+class RenderChain {
+public:
+  RenderChain(double sampleRate, int numChannels, const RenderSettings &settings);
+
+  // Processes the whole buffer in place
+  void process(juce::AudioBuffer<float> &buffer);
+
+  // Output lags input by this many samples
+  int getLatencySamples() const;
+
+private:
+  // Exactly one engine is set, per RenderSettings::doublePrecision
+  std::unique_ptr<NeveTransformerDSP> dsp;
+  std::unique_ptr<NeveTransformerDSPFloat> dspFloat;
+};
+
+/**
+ * Renders an audio file through NeveTransformerDSP (read -> process -> write).
+ * Shared by the GUI export and the headless NeveRender tool so both produce
+ * identical output.
+ *
+ * Serial renders run as a three-stage pipeline: a reader thread, the DSP on
+ * the calling thread and a writer thread hand preallocated blocks to each
+ * other through lock-free queues, so disk I/O and processing overlap and a
+ * slow write only stalls the pipeline once every block is in flight.
+ */
+class OfflineRenderer {
+public:
+  using ProgressCallback = std::function<void(double)>;
+  using CancelCallback = std::function<bool()>;
+
+  explicit OfflineRenderer(juce::AudioFormatManager &formats);
+
+  // Blocking; call from a worker thread. Progress is reported in 0-1.
+  // Dispatches to SegmentedRenderer when settings.maxSegments > 1.
+  RenderResult render(const juce::File &input, const juce::File &output,
+                      const RenderSettings &settings,
+                      ProgressCallback onProgress = {},
+                      CancelCallback shouldCancel = {}) const;
+
+  // ".aiff"/".aif" inputs keep their format, everything else is written as WAV
+  static juce::String getOutputExtensionFor(const juce::File &input);
+
+  // WAV or AIFF writer chosen by the output extension; replaces an existing file.
+  // Writes go out behind a large buffer, as few big writes, which slow or
+  // cloud-synced output folders handle far better than many small ones.
+  static std::unique_ptr<juce::AudioFormatWriter>
+  createWriterFor(const juce::File &output, double sampleRate, int numChannels,
+                  int bitsPerSample, juce::String &error);
+
+  // Memory-mapped reader for WAV and AIFF inputs, falling back to the format
+  // manager for other formats or files that can't be mapped
+  static std::unique_ptr<juce::AudioFormatReader>
+  createReaderFor(juce::AudioFormatManager &formats, const juce::File &input);
+
+  static constexpr size_t writeBufferBytes = 4 << 20;
+
+  // Blocks in flight between the pipeline stages, each settings.blockSize long
+  static constexpr int pipelineDepth = 32;
+
+private:
+  juce::AudioFormatManager &formatManager;
+};
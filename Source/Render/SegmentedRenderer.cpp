@@ -0,0 +1,259 @@
+#include "SegmentedRenderer.h"
+
+namespace {
+
+struct Segment {
+  juce::int64 start = 0, end = 0;               // output range kept from this segment
+  juce::int64 processStart = 0, processEnd = 0; // including pre-roll and overlap
+  std::unique_ptr<juce::TemporaryFile> tempFile; // nullptr: writes the output directly
+  juce::AudioBuffer<float> head; // first output samples (compared with previous tail)
+  juce::AudioBuffer<float> tail; // overlap rendered past the end
+  juce::String error;
+};
+
+// Copies the part of a block at streamPos that falls inside dest's range
+void copyOverlap(const juce::AudioBuffer<float> &block, juce::int64 streamPos,
+                 int numSamples, juce::AudioBuffer<float> &dest,
+                 juce::int64 destStart) {
+  auto from = juce::jmax(streamPos, destStart);
+  auto to = juce::jmin(streamPos + numSamples, destStart + dest.getNumSamples());
+  if (to <= from)
+    return;
+
+  for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+    dest.copyFrom(ch, (int)(from - destStart), block, ch, (int)(from - streamPos),
+                  (int)(to - from));
+}
+
+} // namespace
+
+SegmentedRenderer::SegmentedRenderer(juce::AudioFormatManager &formats)
+    : formatManager(formats) {}
+
+int SegmentedRenderer::getNumSegments(juce::int64 lengthInSamples, double sampleRate,
+                                      const RenderSettings &settings) {
+  if (settings.maxSegments <= 1 || sampleRate <= 0.0)
+    return 1;
+
+  auto minSegmentSamples = (juce::int64)(minSegmentSeconds * sampleRate);
+  auto bySize = (int)juce::jmin((juce::int64)settings.maxSegments,
+                                lengthInSamples / minSegmentSamples);
+  return juce::jmax(1, bySize);
+}
+
+RenderResult SegmentedRenderer::render(const juce::File &input,
+                                       const juce::File &output,
+                                       const RenderSettings &settings,
+                                       OfflineRenderer::ProgressCallback onProgress,
+                                       OfflineRenderer::CancelCallback shouldCancel) const {
+  RenderResult result;
+  result.inputFile = input;
+  result.outputFile = output;
+
+  auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+  auto reader = OfflineRenderer::createReaderFor(formatManager, input);
+
+  if (reader == nullptr) {
+    result.error = "Could not read input file";
+    return result;
+  }
+
+  const juce::int64 length = reader->lengthInSamples;
+  const double sampleRate = reader->sampleRate;
+  const int numChannels = (int)reader->numChannels;
+  const int bitsPerSample = (int)reader->bitsPerSample;
+  const int numSegments = getNumSegments(length, sampleRate, settings);
+
+  if (numSegments <= 1) {
+    auto serial = settings;
+    serial.maxSegments = 1;
+    return OfflineRenderer(formatManager).render(input, output, serial, onProgress,
+                                                 shouldCancel);
+  }
+
+  result.totalSamples = length;
+  result.sampleRate = sampleRate;
+  result.numChannels = numChannels;
+  result.numSegments = numSegments;
+
+  auto writer = OfflineRenderer::createWriterFor(output, sampleRate, numChannels,
+                                                 bitsPerSample, result.error);
+  if (writer == nullptr)
+    return result;
+
+  // Boundaries and pre-roll are block aligned so every segment sees the same
+  // block grid as a continuous render
+  const int blockSize = juce::jmax(1, settings.blockSize);
+  const juce::int64 preRollBlocks =
+      (juce::int64)std::ceil(juce::jmax(0.0, settings.preRollSeconds) * sampleRate / blockSize);
+  const juce::int64 preRoll = preRollBlocks * blockSize;
+  const juce::int64 overlap = (juce::int64)(overlapSeconds * sampleRate);
+
+  std::vector<Segment> segments((size_t)numSegments);
+  juce::int64 totalToProcess = 0;
+
+  for (int k = 0; k < numSegments; ++k) {
+    auto &seg = segments[(size_t)k];
+    seg.start = (length * k / numSegments) / blockSize * blockSize;
+    seg.end = (k == numSegments - 1) ? length
+                                     : (length * (k + 1) / numSegments) / blockSize * blockSize;
+    seg.processStart = juce::jmax((juce::int64)0, seg.start - preRoll);
+    seg.processEnd = (k == numSegments - 1) ? seg.end : juce::jmin(length, seg.end + overlap);
+    if (k > 0) {
+      seg.tempFile = std::make_unique<juce::TemporaryFile>(output.withFileExtension(".wav"));
+      seg.head.setSize(numChannels, (int)juce::jmin(overlap, seg.end - seg.start));
+    }
+    seg.tail.setSize(numChannels, (int)(seg.processEnd - seg.end));
+
+    totalToProcess += seg.processEnd - seg.processStart;
+  }
+
+  std::atomic<juce::int64> samplesDone { 0 };
+  std::atomic<bool> abortRender { false };
+  std::atomic<int> remaining { numSegments };
+  juce::WaitableEvent allDone;
+
+  auto renderSegment = [&](Segment &seg) {
+    auto segReader = OfflineRenderer::createReaderFor(formatManager, input);
+    if (segReader == nullptr) {
+      seg.error = "Could not read input file";
+      return;
+    }
+
+    // Later segments are staged as float so stitching adds no extra
+    // quantisation; the first one owns the output until they're appended
+    std::unique_ptr<juce::AudioFormatWriter> tempWriter;
+    auto *segWriter = writer.get();
+    if (seg.tempFile != nullptr) {
+      tempWriter = OfflineRenderer::createWriterFor(seg.tempFile->getFile(), sampleRate,
+                                                    numChannels, 32, seg.error);
+      if (tempWriter == nullptr)
+        return;
+      segWriter = tempWriter.get();
+    }
+
+    RenderChain chain(sampleRate, numChannels, settings);
+    juce::AudioBuffer<float> buf(numChannels, blockSize);
+    const bool hasRight = numChannels > 1;
+
+    for (auto pos = seg.processStart; pos < seg.processEnd;) {
+      if (abortRender.load(std::memory_order_relaxed)) {
+        seg.error = "Cancelled";
+        return;
+      }
+
+      int n = (int)juce::jmin((juce::int64)blockSize, seg.processEnd - pos);
+      buf.setSize(numChannels, n, false, false, true);
+
+      if (!segReader->read(&buf, 0, n, pos, true, hasRight)) {
+        seg.error = "Read failure at sample " + juce::String(pos);
+        return;
+      }
+
+      chain.process(buf);
+
+      auto keepFrom = juce::jmax(pos, seg.start);
+      auto keepTo = juce::jmin(pos + n, seg.end);
+      if (keepTo > keepFrom &&
+          !segWriter->writeFromAudioSampleBuffer(buf, (int)(keepFrom - pos),
+                                                 (int)(keepTo - keepFrom))) {
+        seg.error = "Failed to write segment";
+        return;
+      }
+
+      copyOverlap(buf, pos, n, seg.head, seg.start);
+      copyOverlap(buf, pos, n, seg.tail, seg.end);
+
+      pos += n;
+      samplesDone.fetch_add(n, std::memory_order_relaxed);
+    }
+  };
+
+  {
+    juce::ThreadPool pool(numSegments);
+
+    for (auto &seg : segments) {
+      pool.addJob([&, segPtr = &seg] {
+        renderSegment(*segPtr);
+        if (!segPtr->error.isEmpty())
+          abortRender.store(true, std::memory_order_relaxed);
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          allDone.signal();
+      });
+    }
+
+    // Rendering takes ~95% of the time, stitching the rest
+    while (!allDone.wait(50)) {
+      if (shouldCancel && shouldCancel())
+        abortRender.store(true, std::memory_order_relaxed);
+      if (onProgress)
+        onProgress(0.95 * (double)samplesDone.load(std::memory_order_relaxed) /
+                   (double)totalToProcess);
+    }
+  }
+
+  for (auto &seg : segments) {
+    if (seg.error.isNotEmpty()) {
+      result.error = seg.error;
+      result.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+      return result;
+    }
+  }
+
+  // Boundary mismatch: previous segment's overlap vs this segment's start
+  double maxDeviation = 0.0;
+  for (size_t k = 1; k < segments.size(); ++k) {
+    const auto &prev = segments[k - 1].tail;
+    const auto &next = segments[k].head;
+    const int n = juce::jmin(prev.getNumSamples(), next.getNumSamples());
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+      auto *a = prev.getReadPointer(ch);
+      auto *b = next.getReadPointer(ch);
+      for (int i = 0; i < n; ++i)
+        maxDeviation = juce::jmax(maxDeviation, (double)std::abs(a[i] - b[i]));
+    }
+  }
+  result.maxSegmentDeviation = maxDeviation;
+
+  // Append the later segments in order after the first
+  juce::AudioBuffer<float> buf(numChannels, blockSize);
+  juce::int64 samplesWritten = segments.front().end - segments.front().start;
+
+  for (size_t k = 1; k < segments.size(); ++k) {
+    auto &seg = segments[k];
+    std::unique_ptr<juce::AudioFormatReader> segReader(
+        formatManager.createReaderFor(seg.tempFile->getFile()));
+    if (segReader == nullptr) {
+      result.error = "Could not read segment";
+      break;
+    }
+
+    for (juce::int64 pos = 0; pos < segReader->lengthInSamples;) {
+      int n = (int)juce::jmin((juce::int64)blockSize, segReader->lengthInSamples - pos);
+      buf.setSize(numChannels, n, false, false, true);
+
+      if (!segReader->read(&buf, 0, n, pos, true, numChannels > 1) ||
+          !writer->writeFromAudioSampleBuffer(buf, 0, n)) {
+        result.error = "Failed to write output";
+        break;
+      }
+
+      pos += n;
+      samplesWritten += n;
+      if (onProgress)
+        onProgress(0.95 + 0.05 * (double)samplesWritten / (double)length);
+    }
+
+    if (result.error.isNotEmpty())
+      break;
+  }
+
+  writer.reset();
+
+  result.samplesProcessed = samplesWritten;
+  result.succeeded = result.error.isEmpty();
+  result.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+  return result;
+}
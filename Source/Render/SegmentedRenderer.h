@@ -0,0 +1,41 @@
+#pragma once
+
+#include "OfflineRenderer.h"
+
+/**
+ * Renders one long file as parallel time segments.
+ *
+ * Every segment runs on its own thread with its own NeveTransformerDSP. It
+ * starts preRollSeconds early so the filter, envelope and oversampler state
+ * has settled by the time its output is kept, and the segments are then
+ * stitched in order. Each segment also renders a short overlap past its end;
+ * comparing that with the next segment's first samples estimates the
+ * mismatch at each boundary, reported in RenderResult. Both sides are
+ * pre-rolled, so this is not the deviation from a serial render, and slow
+ * tails (DC blocker, allpass envelope) can outlast the overlap.
+ *
+ * The first segment writes straight into the output. The others are staged
+ * as 32-bit float temporary files next to it and appended in order, so a
+ * segmented render needs about 4 bytes per sample and channel of extra disk
+ * space and twice that in I/O (over 4 GB for three hours of 48 kHz stereo).
+ */
+class SegmentedRenderer {
+public:
+  // Segments shorter than this are not worth a thread and a pre-roll
+  static constexpr double minSegmentSeconds = 30.0;
+  static constexpr double overlapSeconds = 0.05;
+
+  explicit SegmentedRenderer(juce::AudioFormatManager &formats);
+
+  RenderResult render(const juce::File &input, const juce::File &output,
+                      const RenderSettings &settings,
+                      OfflineRenderer::ProgressCallback onProgress = {},
+                      OfflineRenderer::CancelCallback shouldCancel = {}) const;
+
+  // Number of segments used for a file of the given length
+  static int getNumSegments(juce::int64 lengthInSamples, double sampleRate,
+                            const RenderSettings &settings);
+
+private:
+  juce::AudioFormatManager &formatManager;
+};
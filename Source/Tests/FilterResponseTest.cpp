@@ -0,0 +1,104 @@
+#include "../DSP/NeveTransformerDSP.h"
+#include <complex>
+#include <iostream>
+
+/**
+ * Neve Transformer - filter response test
+ *
+ * Designs every linear stage of the engine (iron shelf, LF pole, HF
+ * resonance, HF roll, post shelf and DC blocker) at its parameter extremes
+ * and at several sample rates, then measures the impulse response of the
+ * SvfCascade stage the engine runs. Fails unless its magnitude and phase
+ * match the direct-form BiquadFilter design at every test frequency, so the
+ * cascade keeps the responses the biquads defined.
+ */
+
+namespace {
+
+constexpr int impulseLength = 1 << 18; // lets the 5 Hz DC blocker ring out at 96 kHz
+constexpr int numFrequencies = 32;     // log-spaced, 10 Hz to 0.45 fs
+constexpr double toleranceDb = 1.0e-6; // magnitude difference; rounding is ~1e-8
+constexpr double toleranceDegrees = 1.0e-5;
+
+struct Stage {
+  const char *name;
+  std::function<void(BiquadFilter &, double sampleRate)> design;
+};
+
+// The engine's designs (see buildCoefficientTables and updateSwitchedFilters)
+const Stage stages[] = {
+  { "iron 0", [](BiquadFilter &f, double fs) { f.setLowShelf(fs, 100.0, 0.0, 0.707); } },
+  { "iron 1", [](BiquadFilter &f, double fs) { f.setLowShelf(fs, 100.0, 2.0, 0.707); } },
+  { "LF pole line", [](BiquadFilter &f, double fs) { f.setHighpass(fs, 60.0, 0.7); } },
+  { "LF pole mic", [](BiquadFilter &f, double fs) { f.setHighpass(fs, 50.0, 0.7); } },
+  { "HF resonance hi-Z",
+    [](BiquadFilter &f, double fs) { f.setPeak(fs, juce::jmin(14000.0, fs * 0.48), 1.5, 1.2); } },
+  { "HF resonance lo-Z",
+    [](BiquadFilter &f, double fs) { f.setPeak(fs, juce::jmin(14000.0, fs * 0.48), 1.5, 0.8); } },
+  { "HF roll 0",
+    [](BiquadFilter &f, double fs) { f.setLowpass(fs, juce::jmin(20000.0, fs * 0.48), 0.707); } },
+  { "HF roll 1",
+    [](BiquadFilter &f, double fs) { f.setLowpass(fs, juce::jmin(30000.0, fs * 0.48), 0.707); } },
+  { "post shelf", [](BiquadFilter &f, double fs) { f.setLowShelf(fs, 80.0, 0.2, 0.707); } },
+  { "DC blocker", [](BiquadFilter &f, double fs) { f.setHighpass(fs, 5.0, 0.707); } },
+};
+
+double toDb(double value) { return 20.0 * std::log10(juce::jmax(value, 1.0e-30)); }
+
+// Direct-form transfer function at normalised angular frequency w
+std::complex<double> biquadResponse(const BiquadFilter::Coefficients &c, double w) {
+  const auto z1 = std::polar(1.0, -w), z2 = std::polar(1.0, -2.0 * w);
+  return (c.b0 + c.b1 * z1 + c.b2 * z2) / (1.0 + c.a1 * z1 + c.a2 * z2);
+}
+
+// DFT of the cascade's impulse response at normalised angular frequency w
+std::complex<double> measuredResponse(const std::vector<double> &impulse, double w) {
+  const auto rotation = std::polar(1.0, -w);
+  std::complex<double> phasor = 1.0, sum = 0.0;
+  for (size_t i = 0; i < impulse.size(); ++i) {
+    sum += impulse[i] * phasor;
+    phasor *= rotation;
+    if ((i & 1023) == 1023)
+      phasor /= std::abs(phasor); // keep the rotation on the unit circle
+  }
+  return sum;
+}
+
+bool runStage(const Stage &stage, double sampleRate) {
+  BiquadFilter design;
+  stage.design(design, sampleRate);
+
+  using Cascade = SvfCascade<1, double>;
+  Cascade cascade;
+  cascade.setStage(0, design);
+  std::vector<double> impulse((size_t)impulseLength);
+  for (int i = 0; i < impulseLength; ++i)
+    impulse[(size_t)i] = cascade.processFrame(Cascade::Vec::expand(i == 0 ? 1.0 : 0.0)).get(0);
+
+  double maxDb = 0.0, maxDegrees = 0.0;
+  for (int i = 0; i < numFrequencies; ++i) {
+    const double hz = 10.0 * std::pow(0.45 * sampleRate / 10.0, (double)i / (numFrequencies - 1));
+    const double w = juce::MathConstants<double>::twoPi * hz / sampleRate;
+    const auto expected = biquadResponse(design.getCoefficients(), w);
+    const auto measured = measuredResponse(impulse, w);
+    maxDb = juce::jmax(maxDb, std::abs(toDb(std::abs(measured)) - toDb(std::abs(expected))));
+    const double degrees = juce::radiansToDegrees(std::arg(measured / expected));
+    maxDegrees = juce::jmax(maxDegrees, std::abs(degrees));
+  }
+
+  const bool ok = maxDb < toleranceDb && maxDegrees < toleranceDegrees;
+  std::cout << (ok ? "PASS " : "FAIL ") << stage.name << " at " << sampleRate << " Hz: "
+            << maxDb << " dB, " << maxDegrees << " degrees" << std::endl;
+  return ok;
+}
+
+} // namespace
+
+int main() {
+  bool passed = true;
+  for (const double sampleRate : { 44100.0, 48000.0, 96000.0 })
+    for (const auto &stage : stages)
+      passed = runStage(stage, sampleRate) && passed;
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include "RegressionCases.h"
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <iostream>
+
+/**
+ * Neve Transformer - golden output regression test
+ *
+ * Renders the fixed regression programme through every regression case and
+ * compares each render with its golden file (<golden-dir>/<case>.wav,
+ * 32-bit float, so stored exactly). Fails if the peak difference exceeds
+ * -100 dBFS: far below audibility, well above the rounding that compilers,
+ * FMA contraction and libm add across platforms, or if a golden file is
+ * missing or unreadable. Only --update writes golden files: it records all
+ * of them, from a Release build, after an intentional change to the sound.
+ */
+
+namespace {
+
+constexpr double toleranceDb = -100.0; // peak difference, dBFS
+constexpr int goldenBitDepth = 32; // float
+
+double toDb(double value) { return 20.0 * std::log10(juce::jmax(value, 1.0e-30)); }
+
+bool writeGolden(const juce::File &file, const juce::AudioBuffer<float> &render) {
+  file.deleteFile();
+  auto *stream = file.createOutputStream().release();
+  if (stream == nullptr)
+    return false;
+
+  juce::WavAudioFormat wav;
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      wav.createWriterFor(stream, regression::sampleRate, (unsigned)render.getNumChannels(),
+                          goldenBitDepth, {}, 0));
+  if (writer == nullptr) {
+    delete stream;
+    return false;
+  }
+  return writer->writeFromAudioSampleBuffer(render, 0, render.getNumSamples());
+}
+
+bool readGolden(juce::AudioFormatManager &formats, const juce::File &file,
+                juce::AudioBuffer<float> &golden) {
+  std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+  if (reader == nullptr || reader->lengthInSamples != regression::programLength ||
+      (int)reader->numChannels != regression::numChannels)
+    return false;
+
+  golden.setSize(regression::numChannels, regression::programLength);
+  return reader->read(&golden, 0, regression::programLength, 0, true, true);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  juce::ArgumentList args(argc, argv);
+  const auto goldenDir = args.containsOption("--golden-dir")
+                             ? args.getFileForOption("--golden-dir")
+                             : juce::File::getCurrentWorkingDirectory().getChildFile("Golden");
+  const bool update = args.containsOption("--update");
+  if (update && !goldenDir.createDirectory()) {
+    std::cout << "FAIL: can't create " << goldenDir.getFullPathName() << std::endl;
+    return 1;
+  }
+
+  juce::AudioFormatManager formats;
+  formats.registerBasicFormats();
+  const auto program = regression::makeProgram();
+
+  bool passed = true;
+
+  for (const auto &testCase : regression::cases) {
+    const auto render = regression::renderProgram(testCase, program);
+    const auto file = goldenDir.getChildFile(juce::String(testCase.name) + ".wav");
+
+    juce::AudioBuffer<float> golden;
+    if (update) {
+      const bool written = writeGolden(file, render);
+      passed = passed && written;
+      std::cout << (written ? "RECORDED " : "FAIL ") << testCase.name << ": "
+                << file.getFullPathName() << std::endl;
+      continue;
+    }
+    if (!file.existsAsFile()) {
+      passed = false;
+      std::cout << "FAIL " << testCase.name << ": missing " << file.getFullPathName()
+                << " (record it with --update)" << std::endl;
+      continue;
+    }
+    if (!readGolden(formats, file, golden)) {
+      passed = false;
+      std::cout << "FAIL " << testCase.name << ": unreadable or mismatched "
+                << file.getFullPathName() << std::endl;
+      continue;
+    }
+
+    double maxDiff = 0.0, sumSquares = 0.0;
+    for (int ch = 0; ch < regression::numChannels; ++ch) {
+      const float *a = render.getReadPointer(ch);
+      const float *b = golden.getReadPointer(ch);
+      for (int i = 0; i < regression::programLength; ++i) {
+        const double diff = (double)a[i] - (double)b[i];
+        maxDiff = juce::jmax(maxDiff, std::abs(diff));
+        sumSquares += diff * diff;
+      }
+    }
+    const double rms =
+        std::sqrt(sumSquares / (double)(regression::numChannels * regression::programLength));
+
+    const bool ok = toDb(maxDiff) < toleranceDb;
+    passed = passed && ok;
+    std::cout << (ok ? "PASS " : "FAIL ") << testCase.name << ": max "
+              << juce::String(toDb(maxDiff), 1) << " dB, rms " << juce::String(toDb(rms), 1)
+              << " dB" << std::endl;
+  }
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+#include "../DSP/NeveTransformerDSP.h"
+#include <iostream>
+#include <random>
+
+/**
+ * Neve Transformer - latency-compensated mix test
+ *
+ * Renders noise at every oversampling factor, with the linear-phase and
+ * low-latency filters, fully dry, fully wet, half and half, and bypassed.
+ * Fails unless the dry and bypassed renders are the input delayed by
+ * exactly getLatencySamples(), and the half mix is the average of the dry
+ * and wet renders, so the two paths never comb-filter.
+ */
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 512;
+constexpr int numBlocks = 40;
+constexpr int streamLength = blockSize * numBlocks;
+constexpr double toleranceDb = -120.0; // peak deviation of the half mix, dBFS
+
+enum class Path { MIX, BYPASS };
+
+std::vector<float> render(const std::vector<float> &input, int oversampling, bool lowLatency,
+                          Path path, double mix, int &latency) {
+  NeveTransformerDSPFloat dsp;
+  dsp.setOversamplingFactor(oversampling);
+  dsp.setLowLatency(lowLatency);
+  dsp.setMix(mix);
+  dsp.setBypassed(path == Path::BYPASS);
+  dsp.setDrive(0.8);
+  dsp.prepare(sampleRate, blockSize);
+  latency = dsp.getLatencySamples();
+
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  std::vector<float> output(input.size());
+  for (int pos = 0; pos < streamLength; pos += blockSize) {
+    for (int ch = 0; ch < 2; ++ch)
+      buffer.copyFrom(ch, 0, input.data() + (size_t)(ch * streamLength + pos), blockSize);
+
+    dsp.processBlock(buffer);
+
+    for (int ch = 0; ch < 2; ++ch)
+      std::copy(buffer.getReadPointer(ch), buffer.getReadPointer(ch) + blockSize,
+                output.begin() + (ch * streamLength + pos));
+  }
+  return output;
+}
+
+// Samples that differ from the input delayed by latency
+size_t countDelayMismatches(const std::vector<float> &input, const std::vector<float> &output,
+                            int latency) {
+  size_t mismatches = 0;
+  for (int ch = 0; ch < 2; ++ch)
+    for (int i = 0; i < streamLength; ++i) {
+      const float expected = i >= latency ? input[(size_t)(ch * streamLength + i - latency)] : 0.0f;
+      if (output[(size_t)(ch * streamLength + i)] != expected)
+        ++mismatches;
+    }
+  return mismatches;
+}
+
+double toDb(double value) { return 20.0 * std::log10(juce::jmax(value, 1.0e-30)); }
+
+} // namespace
+
+int main() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> noise(-0.8f, 0.8f);
+  std::vector<float> input((size_t)(2 * streamLength));
+  for (auto &sample : input)
+    sample = noise(rng);
+
+  bool passed = true;
+
+  for (int oversampling : { 1, 2, 4, 8, 16 }) {
+    for (bool lowLatency : { false, true }) {
+      int latency = 0, bypassLatency = 0;
+      const auto dry = render(input, oversampling, lowLatency, Path::MIX, 0.0, latency);
+      const auto wet = render(input, oversampling, lowLatency, Path::MIX, 1.0, latency);
+      const auto half = render(input, oversampling, lowLatency, Path::MIX, 0.5, latency);
+      const auto bypassed = render(input, oversampling, lowLatency, Path::BYPASS, 1.0, bypassLatency);
+
+      double maxDiff = 0.0;
+      for (size_t i = 0; i < half.size(); ++i)
+        maxDiff = juce::jmax(maxDiff, std::abs((double)half[i] - 0.5 * ((double)dry[i] + wet[i])));
+
+      const size_t dryMismatches = countDelayMismatches(input, dry, latency);
+      const size_t bypassMismatches = countDelayMismatches(input, bypassed, bypassLatency);
+      const bool ok = dryMismatches == 0 && bypassMismatches == 0 && toDb(maxDiff) < toleranceDb;
+      passed = passed && ok;
+      std::cout << (ok ? "PASS " : "FAIL ") << oversampling << "x"
+                << (lowLatency ? " low latency" : "") << ": latency " << latency << ", dry "
+                << (int)dryMismatches << " and bypass " << (int)bypassMismatches
+                << " samples off, half mix " << toDb(maxDiff) << " dB" << std::endl;
+    }
+  }
+
+  return passed ? 0 : 1;
+}
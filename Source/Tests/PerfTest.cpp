@@ -0,0 +1,144 @@
+#include "RegressionCases.h"
+#include <iostream>
+
+/**
+ * Neve Transformer - throughput regression test
+ *
+ * Times processBlock for every regression case on the regression programme
+ * and compares ns/sample with this machine's stored baseline
+ * (<baseline-dir>/<computer>-<cpu>.json). Fails when any case is more than
+ * --threshold (default 10%) slower. Each case runs a warm-up round and
+ * seven timed ones; the best round is compared, as the least disturbed by
+ * other load. A missing baseline, or cases missing from it, are recorded and
+ * the test reports as skipped; --update re-records the baseline after an
+ * accepted change. Debug builds only report as skipped.
+ */
+
+namespace {
+
+constexpr int numRounds = 7;
+constexpr int skippedExitCode = 77; // SKIP_RETURN_CODE in CMakeLists.txt
+
+// Best ns per sample frame over the timed rounds, looping the programme
+template <typename Engine>
+double timeCase(const regression::Case &testCase, const juce::AudioBuffer<float> &program,
+                double roundSeconds) {
+  Engine dsp;
+  regression::prepareEngine(dsp, testCase);
+  regression::queueAutomation(dsp, testCase);
+
+  juce::AudioBuffer<float> buffer(regression::numChannels, regression::blockSize);
+  int pos = 0;
+  auto runBlock = [&] {
+    for (int ch = 0; ch < regression::numChannels; ++ch)
+      buffer.copyFrom(ch, 0, program, ch, pos, regression::blockSize);
+    dsp.processBlock(buffer);
+    pos = (pos + regression::blockSize) % (regression::programLength - regression::blockSize);
+  };
+
+  double best = 0.0;
+  for (int round = -1; round < numRounds; ++round) { // round -1 warms up
+    const auto start = juce::Time::getHighResolutionTicks();
+    const auto limit = juce::Time::secondsToHighResolutionTicks(roundSeconds);
+    juce::int64 blocks = 0, now;
+    do {
+      runBlock();
+      ++blocks;
+      now = juce::Time::getHighResolutionTicks();
+    } while (now - start < limit);
+
+    const double ns = juce::Time::highResolutionTicksToSeconds(now - start) * 1.0e9 /
+                      (double)(blocks * regression::blockSize);
+    if (round >= 0 && (round == 0 || ns < best))
+      best = ns;
+  }
+  return best;
+}
+
+juce::File getBaselineFile(const juce::File &directory) {
+  const auto machine = juce::SystemStats::getComputerName() + "-" + juce::SystemStats::getCpuModel();
+  return directory.getChildFile(
+      juce::File::createLegalFileName(machine.replaceCharacter(' ', '_')) + ".json");
+}
+
+bool writeBaseline(const juce::File &file, juce::DynamicObject *results) {
+  auto *machine = new juce::DynamicObject();
+  machine->setProperty("computer", juce::SystemStats::getComputerName());
+  machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+  machine->setProperty("cores", juce::SystemStats::getNumCpus());
+  machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+
+  auto *root = new juce::DynamicObject();
+  root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+  root->setProperty("machine", juce::var(machine));
+  root->setProperty("nsPerSample", juce::var(results));
+  return file.replaceWithText(juce::JSON::toString(juce::var(root)));
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+#if JUCE_DEBUG
+  juce::ignoreUnused(argc, argv);
+  std::cout << "SKIP: timings need a Release build" << std::endl;
+  return skippedExitCode;
+#else
+  juce::ArgumentList args(argc, argv);
+  const auto baselineDir = args.containsOption("--baseline-dir")
+                               ? args.getFileForOption("--baseline-dir")
+                               : juce::File::getCurrentWorkingDirectory().getChildFile("Baselines");
+  const bool update = args.containsOption("--update");
+  double threshold = 0.10;
+  if (args.containsOption("--threshold"))
+    threshold = juce::jmax(0.0, args.getValueForOption("--threshold").getDoubleValue());
+  double roundSeconds = 0.1;
+  if (args.containsOption("--round-time"))
+    roundSeconds = juce::jmax(0.001, args.getValueForOption("--round-time").getDoubleValue());
+
+  const auto baselineFile = getBaselineFile(baselineDir);
+  const auto baseline = update ? juce::var() : juce::JSON::parse(baselineFile);
+  juce::DynamicObject::Ptr results = new juce::DynamicObject();
+  if (auto *stored = baseline["nsPerSample"].getDynamicObject())
+    results = stored->clone();
+
+  const auto program = regression::makeProgram();
+  bool passed = true, recorded = false;
+
+  for (const auto &testCase : regression::cases) {
+    const double ns =
+        testCase.singlePrecision
+            ? timeCase<NeveTransformerDSPFloat>(testCase, program, roundSeconds)
+            : timeCase<NeveTransformerDSP>(testCase, program, roundSeconds);
+
+    if (!results->hasProperty(testCase.name)) {
+      results->setProperty(testCase.name, ns);
+      recorded = true;
+      std::cout << "RECORDED " << testCase.name << ": " << juce::String(ns, 2) << " ns/sample"
+                << std::endl;
+      continue;
+    }
+
+    const double reference = results->getProperty(testCase.name);
+    const double change = ns / reference - 1.0;
+    const bool ok = change <= threshold;
+    passed = passed && ok;
+    std::cout << (ok ? "PASS " : "FAIL ") << testCase.name << ": " << juce::String(ns, 2)
+              << " ns/sample, baseline " << juce::String(reference, 2) << " ("
+              << (change >= 0.0 ? "+" : "") << juce::String(change * 100.0, 1) << "%)"
+              << std::endl;
+  }
+
+  if (recorded) {
+    baselineDir.createDirectory();
+    if (!writeBaseline(baselineFile, results.get())) {
+      std::cout << "FAIL: could not write " << baselineFile.getFullPathName() << std::endl;
+      return 1;
+    }
+    std::cout << "Baseline: " << baselineFile.getFullPathName() << std::endl;
+  }
+
+  if (!passed)
+    return 1;
+  return recorded && !update ? skippedExitCode : 0;
+#endif
+}
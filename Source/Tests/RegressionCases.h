@@ -0,0 +1,116 @@
+#pragma once
+
+#include "../DSP/NeveTransformerDSP.h"
+
+/**
+ * Fixed engine configurations and test programme shared by the golden
+ * output and throughput regression tests, so a speed-up is measured on
+ * exactly the renders whose sound is pinned.
+ */
+namespace regression {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 512;
+constexpr int numChannels = 2;
+constexpr int programLength = 48000; // 1 s: sweep, noise bursts, hot tones
+
+struct Case {
+  const char *name;
+  bool singlePrecision; // NeveTransformerDSPFloat instead of NeveTransformerDSP
+  int oversampling;
+  OversamplingFilter filter;
+  bool lowLatency;
+  WaveshaperMode shaperMode;
+  EngineParameters parameters;
+};
+
+// One per processing path worth pinning: precision, shaper approximation,
+// oversampling design and the mix path
+const Case cases[] = {
+  { "default", false, 4, OversamplingFilter::FIR, false, WaveshaperMode::FAST, {} },
+  { "default-float", true, 4, OversamplingFilter::FIR, false, WaveshaperMode::FAST, {} },
+  { "hot-reference", false, 4, OversamplingFilter::FIR, false, WaveshaperMode::REFERENCE,
+    { 1.0, 1.0, 0.0, true, false, 1.0 } },
+  { "hot-adaa-2x", false, 2, OversamplingFilter::FIR, false, WaveshaperMode::ADAA,
+    { 1.0, 1.0, 0.0, true, false, 1.0 } },
+  { "low-latency-float", true, 4, OversamplingFilter::FIR, true, WaveshaperMode::FAST, {} },
+  { "iir-8x-mix", false, 8, OversamplingFilter::IIR, false, WaveshaperMode::FAST,
+    { 0.7, 0.3, 0.5, false, true, 0.5 } },
+};
+
+/**
+ * Deterministic stereo programme (juce::Random, so identical on every
+ * platform): a log sine sweep 20 Hz-20 kHz at -6 dBFS, noise bursts
+ * between digital silence, then hot 100 Hz + 3 kHz tones at +3 dBFS
+ */
+inline juce::AudioBuffer<float> makeProgram() {
+  juce::AudioBuffer<float> program(numChannels, programLength);
+  juce::Random random(23);
+  const int sweepEnd = programLength * 2 / 5, burstEnd = programLength * 7 / 10;
+  const double sweepSeconds = sweepEnd / sampleRate;
+  const double sweepRatio = std::log(20000.0 / 20.0);
+  const double twoPi = juce::MathConstants<double>::twoPi;
+
+  for (int i = 0; i < programLength; ++i) {
+    const double t = i / sampleRate;
+    double left = 0.0, right = 0.0;
+    if (i < sweepEnd) {
+      const double phase =
+          twoPi * 20.0 * sweepSeconds / sweepRatio * (std::exp(t / sweepSeconds * sweepRatio) - 1.0);
+      left = 0.5 * std::sin(phase);
+      right = 0.5 * std::cos(phase);
+    } else if (i < burstEnd) {
+      if ((i - sweepEnd) % 4800 < 2400) {
+        left = 0.8 * (random.nextDouble() * 2.0 - 1.0);
+        right = 0.8 * (random.nextDouble() * 2.0 - 1.0);
+      }
+    } else {
+      left = 0.7 * std::sin(twoPi * 100.0 * t) + 0.7 * std::sin(twoPi * 3000.0 * t);
+      right = 0.7 * std::sin(twoPi * 100.0 * t + 1.0) + 0.7 * std::sin(twoPi * 3000.0 * t);
+    }
+    program.setSample(0, i, (float)left);
+    program.setSample(1, i, (float)right);
+  }
+  return program;
+}
+
+template <typename Engine>
+void prepareEngine(Engine &dsp, const Case &testCase) {
+  dsp.setOversamplingFactor(testCase.oversampling);
+  dsp.setOversamplingFilter(testCase.filter);
+  dsp.setLowLatency(testCase.lowLatency);
+  dsp.setWaveshaperMode(testCase.shaperMode);
+  dsp.setParameters(testCase.parameters);
+  dsp.prepare(sampleRate, blockSize, numChannels);
+}
+
+/** Mid-programme automation: a drive ramp in the bursts, an iron ramp in the tones */
+template <typename Engine>
+void queueAutomation(Engine &dsp, const Case &testCase) {
+  dsp.setDrive(juce::jmin(1.0, testCase.parameters.drive + 0.4), programLength / 2);
+  dsp.setIron(1.0 - testCase.parameters.iron, programLength * 4 / 5);
+}
+
+/** The programme through a freshly prepared engine, in blockSize blocks */
+template <typename Engine>
+juce::AudioBuffer<float> renderWith(const Case &testCase, const juce::AudioBuffer<float> &program) {
+  Engine dsp;
+  prepareEngine(dsp, testCase);
+  queueAutomation(dsp, testCase);
+
+  juce::AudioBuffer<float> output(program);
+  for (int pos = 0; pos < programLength; pos += blockSize) {
+    juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, pos,
+                                   juce::jmin(blockSize, programLength - pos));
+    dsp.processBlock(block);
+  }
+  return output;
+}
+
+inline juce::AudioBuffer<float> renderProgram(const Case &testCase,
+                                              const juce::AudioBuffer<float> &program) {
+  return testCase.singlePrecision ? renderWith<NeveTransformerDSPFloat>(testCase, program)
+                                  : renderWith<NeveTransformerDSP>(testCase, program);
+}
+
+} // namespace regression
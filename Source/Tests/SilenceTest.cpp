@@ -0,0 +1,94 @@
+#include "../DSP/NeveTransformerDSP.h"
+#include <iostream>
+#include <random>
+
+/**
+ * Neve Transformer - idle sleep test
+ *
+ * Renders noise bursts separated by digital silence with idle sleep on and
+ * off, for both engines. Fails unless the engine falls asleep within each
+ * gap, wakes for the next burst, and stays within the tolerance of the
+ * always-processing render.
+ */
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 512;
+constexpr int burstBlocks = 24;  // ~0.25 s
+constexpr int gapBlocks = 140;   // ~1.5 s
+constexpr int numBursts = 4;
+constexpr double toleranceDb = -100.0; // peak difference, dBFS
+
+struct Render {
+  std::vector<float> output;
+  int gapsAsleep = 0;       // gaps that ended asleep
+  int burstsAwake = 0;      // bursts processed awake
+  int firstSleepBlock = -1; // into the first gap
+};
+
+template <typename Engine>
+Render render(bool idleSleep) {
+  Engine dsp;
+  dsp.setIdleSleepEnabled(idleSleep);
+  dsp.prepare(sampleRate, blockSize);
+  dsp.setDrive(0.9);
+  dsp.setIron(0.8);
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> noise(-0.9f, 0.9f);
+  juce::AudioBuffer<float> buffer(2, blockSize);
+  Render result;
+
+  for (int burst = 0; burst < numBursts; ++burst) {
+    for (int block = 0; block < burstBlocks + gapBlocks; ++block) {
+      const bool sound = block < burstBlocks;
+      for (int ch = 0; ch < 2; ++ch) {
+        auto *data = buffer.getWritePointer(ch);
+        for (int i = 0; i < blockSize; ++i)
+          data[i] = sound ? noise(rng) : 0.0f;
+      }
+
+      dsp.processBlock(buffer);
+
+      if (block == 0 && !dsp.isSleeping())
+        ++result.burstsAwake;
+      if (burst == 0 && !sound && result.firstSleepBlock < 0 && dsp.isSleeping())
+        result.firstSleepBlock = block - burstBlocks;
+      if (block == burstBlocks + gapBlocks - 1 && dsp.isSleeping())
+        ++result.gapsAsleep;
+
+      for (int ch = 0; ch < 2; ++ch)
+        result.output.insert(result.output.end(), buffer.getReadPointer(ch),
+                             buffer.getReadPointer(ch) + blockSize);
+    }
+  }
+  return result;
+}
+
+double toDb(double value) { return 20.0 * std::log10(juce::jmax(value, 1.0e-30)); }
+
+template <typename Engine>
+bool check(const char *name) {
+  auto reference = render<Engine>(false);
+  auto sleepy = render<Engine>(true);
+
+  double maxDiff = 0.0;
+  for (size_t i = 0; i < reference.output.size(); ++i)
+    maxDiff = juce::jmax(maxDiff, std::abs((double)reference.output[i] - sleepy.output[i]));
+
+  bool ok = sleepy.gapsAsleep == numBursts && sleepy.burstsAwake == numBursts &&
+            reference.gapsAsleep == 0 && toDb(maxDiff) < toleranceDb;
+  std::cout << (ok ? "PASS " : "FAIL ") << name << ": asleep in " << sleepy.gapsAsleep << "/"
+            << numBursts << " gaps after " << sleepy.firstSleepBlock * blockSize * 1000.0 / sampleRate
+            << " ms, max difference " << toDb(maxDiff) << " dB" << std::endl;
+  return ok;
+}
+
+} // namespace
+
+int main() {
+  bool passed = check<NeveTransformerDSP>("double");
+  passed = check<NeveTransformerDSPFloat>("float") && passed;
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../DSP/CommandQueue.h"
+#include "../DSP/StageProfiler.h"
+#include <juce_core/juce_core.h>
+
+/**
+ * Whole-callback timing against the device buffer period: every callback's
+ * duration goes into a LatencyHistogram, and every callback that overruns
+ * its period is counted and queued with a timestamp. The audio thread never
+ * blocks; the message thread collects the misses into a session log and
+ * can dump everything to a text file for a post-mortem.
+ */
+class CallbackMonitor {
+public:
+  struct DeadlineMiss {
+    double timeMs = 0.0; // juce::Time::getMillisecondCounterHiRes()
+    juce::uint64 callback = 0;
+    double durationUs = 0.0;
+    double budgetUs = 0.0;
+  };
+
+  /** Audio thread: one finished callback */
+  void record(juce::int64 elapsedTicks, int numSamples, double sampleRate) {
+    const double durationUs = (double)elapsedTicks * usPerTick;
+    const double budgetUs = sampleRate > 0.0 ? 1.0e6 * numSamples / sampleRate : 0.0;
+    histogram.record((juce::uint64)(durationUs * 1.0e3));
+    lastBudgetUs.store(budgetUs, std::memory_order_relaxed);
+
+    const auto callback = numCallbacks.load(std::memory_order_relaxed);
+    numCallbacks.store(callback + 1, std::memory_order_relaxed);
+    if (budgetUs > 0.0 && durationUs > budgetUs) {
+      numMisses.store(numMisses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      if (!pendingMisses.push({ juce::Time::getMillisecondCounterHiRes(), callback, durationUs, budgetUs }))
+        numDropped.store(numDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+  }
+
+  const LatencyHistogram &getHistogram() const { return histogram; }
+  juce::uint64 getNumCallbacks() const { return numCallbacks.load(std::memory_order_relaxed); }
+  juce::uint64 getNumMisses() const { return numMisses.load(std::memory_order_relaxed); }
+  double getBudgetUs() const { return lastBudgetUs.load(std::memory_order_relaxed); }
+
+  /** Message thread: moves queued misses into the session log */
+  void collectMisses() {
+    while (auto *miss = pendingMisses.peek()) {
+      missLog.add(*miss);
+      pendingMisses.pop();
+    }
+  }
+
+  /** Message thread */
+  const juce::Array<DeadlineMiss> &getMissLog() const { return missLog; }
+
+  /** Message thread: statistics, histogram bins and every miss as text */
+  bool dumpToFile(const juce::File &file, const juce::String &header) {
+    collectMisses();
+    const auto stats = histogram.getStats();
+    const double startMs = sessionStartMs;
+
+    juce::String text;
+    text << header << "\n";
+    text << "Callbacks: " << juce::String((juce::int64)getNumCallbacks())
+         << ", deadline misses: " << juce::String((juce::int64)getNumMisses())
+         << " (" << juce::String((juce::int64)numDropped.load(std::memory_order_relaxed))
+         << " not logged)\n";
+    text << "Budget: " << juce::String(getBudgetUs(), 1) << " us\n";
+    text << "Duration us: min " << juce::String(stats.minUs, 1) << ", mean "
+         << juce::String(stats.meanUs, 1) << ", p99 " << juce::String(stats.p99Us, 1)
+         << ", p99.9 " << juce::String(stats.p999Us, 1) << ", max "
+         << juce::String(stats.maxUs, 1) << "\n\n";
+
+    text << "Histogram (bin upper edge us, callbacks)\n";
+    for (int bin = 0; bin < LatencyHistogram::numBins; ++bin)
+      if (auto count = histogram.getBinCount(bin))
+        text << juce::String((double)LatencyHistogram::getBinUpperEdge(bin) * 1.0e-3, 3) << "\t"
+             << juce::String((juce::int64)count) << "\n";
+
+    text << "\nDeadline misses (session time s, callback, duration us, budget us)\n";
+    for (const auto &miss : missLog)
+      text << juce::String((miss.timeMs - startMs) * 1.0e-3, 3) << "\t"
+           << juce::String((juce::int64)miss.callback) << "\t"
+           << juce::String(miss.durationUs, 1) << "\t" << juce::String(miss.budgetUs, 1) << "\n";
+
+    return file.replaceWithText(text);
+  }
+
+private:
+  const double usPerTick = 1.0e6 / (double)juce::Time::getHighResolutionTicksPerSecond();
+  LatencyHistogram histogram;
+  std::atomic<juce::uint64> numCallbacks { 0 };
+  std::atomic<juce::uint64> numMisses { 0 };
+  std::atomic<juce::uint64> numDropped { 0 };
+  std::atomic<double> lastBudgetUs { 0.0 };
+  SpscQueue<DeadlineMiss, 512> pendingMisses;
+
+  // Message thread
+  juce::Array<DeadlineMiss> missLog;
+  const double sessionStartMs = juce::Time::getMillisecondCounterHiRes();
+};
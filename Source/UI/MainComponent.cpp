@@ -2,7 +2,7 @@
 
 MainComponent::MainComponent()
     : progressBar(progress),
-      thumbnail(512, formatManager, thumbnailCache) {
+      waveformPeaks(formatManager, getPeakCacheDirectory()) {
   setSize(1000, 750);
   setOpaque(true);
   setLookAndFeel(&neveLookAndFeel);
@@ -105,7 +105,7 @@ MainComponent::MainComponent()
   mixSlider.setSliderStyle(juce::Slider::RotaryVerticalDrag);
   mixSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 22);
   mixSlider.onValueChange = [this]() {
-    mixValue.store((float)mixSlider.getValue(), std::memory_order_relaxed);
+    dsp.setMix(mixSlider.getValue());
   };
 
   addAndMakeVisible(mixLabel);
@@ -140,6 +140,15 @@ MainComponent::MainComponent()
     dsp.setBypassed(bypassButton.getToggleState());
   };
 
+  // Low-latency monitoring (IIR oversampling), switched on the audio thread
+  addAndMakeVisible(lowLatencyButton);
+  lowLatencyButton.setLookAndFeel(&neveLookAndFeel);
+  lowLatencyButton.setButtonText("LOW LATENCY");
+  lowLatencyButton.setToggleState(false, juce::dontSendNotification);
+  lowLatencyButton.onClick = [this]() {
+    dsp.setLowLatency(lowLatencyButton.getToggleState());
+  };
+
   // A/B comparison button
   addAndMakeVisible(abButton);
   abButton.setButtonText("A");
@@ -208,6 +217,23 @@ MainComponent::MainComponent()
   statusLog.setFont(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
   statusLog.setText("Initializing audio...\n", false);
 
+  // Per-stage callback timings, appended to the status log on demand
+  dsp.setProfiler(&profiler);
+  addAndMakeVisible(stagesButton);
+  stagesButton.setButtonText("STAGES");
+  stagesButton.setLookAndFeel(&neveLookAndFeel);
+  stagesButton.onClick = [this]() {
+    statusLog.moveCaretToEnd();
+    statusLog.insertTextAtCaret("\n" + profiler.getSummary());
+    profiler.reset();
+  };
+
+  // Callback deadline post-mortem: histogram, misses and stage timings
+  addAndMakeVisible(dumpTimingButton);
+  dumpTimingButton.setButtonText("DUMP");
+  dumpTimingButton.setLookAndFeel(&neveLookAndFeel);
+  dumpTimingButton.onClick = [this]() { dumpCallbackTiming(); };
+
   // File / Transport Section
   addAndMakeVisible(fileProcessingLabel);
   fileProcessingLabel.setText("AUDIO FILE:", juce::dontSendNotification);
@@ -263,6 +289,24 @@ MainComponent::MainComponent()
   exportButton.setEnabled(false);
   exportButton.onClick = [this] { exportProcessedFile(); };
 
+  // Parallel export (off by default): long files render as time segments on
+  // every core, within a small deviation of the serial render
+  addAndMakeVisible(parallelExportToggle);
+  parallelExportToggle.setButtonText("PARALLEL");
+  parallelExportToggle.setLookAndFeel(&neveLookAndFeel);
+  parallelExportToggle.setToggleState(false, juce::dontSendNotification);
+
+  // Batch export button (doubles as cancel while a batch is running)
+  addAndMakeVisible(batchExportButton);
+  batchExportButton.setButtonText("BATCH...");
+  batchExportButton.setLookAndFeel(&neveLookAndFeel);
+  batchExportButton.onClick = [this] {
+    if (batchRenderer != nullptr && batchRenderer->isRunning())
+      batchRenderer->cancel();
+    else
+      selectBatchInput();
+  };
+
   // Output location display
   addAndMakeVisible(outputLocationLabel);
   outputLocationLabel.setText("Output: herrstrom/", juce::dontSendNotification);
@@ -344,6 +388,8 @@ MainComponent::MainComponent()
 }
 
 MainComponent::~MainComponent() {
+  batchRenderer.reset();
+  waveformPeaks.clear();
   stopPlayback();
   transportSource.setSource(nullptr);
   readerSource.reset();
@@ -352,12 +398,10 @@ MainComponent::~MainComponent() {
 }
 
 void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate) {
-  const int safeBlockSize = juce::jmax(samplesPerBlockExpected, 8192);
-
-  dsp.prepare(sampleRate, safeBlockSize);
-
-  tempBuffer.setSize(2, safeBlockSize);
-  dryBuffer.setSize(2, safeBlockSize);
+  // The DSP works on the device buffer in place and chunks larger blocks
+  // itself, so an oversized device callback never reallocates
+  dsp.prepare(sampleRate, juce::jmax(1, samplesPerBlockExpected));
+  deviceSampleRate = sampleRate;
 
   transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
 
@@ -366,76 +410,37 @@ void MainComponent::prepareToPlay(int samplesPerBlockExpected, double sampleRate
   dsp.setHFRoll(hfRollSlider.getValue());
   dsp.setMode(modeButton.getToggleState());
   dsp.setZLoad(zLoadButton.getToggleState());
+  dsp.setMix(mixSlider.getValue());
 
   updateLatencyDisplay();
 }
 
 void MainComponent::getNextAudioBlock(
     const juce::AudioSourceChannelInfo &bufferToFill) {
+  const auto callbackStart = juce::Time::getHighResolutionTicks();
   auto *buffer = bufferToFill.buffer;
   const int numSamples = bufferToFill.numSamples;
-  const int numChannels = buffer->getNumChannels();
-
-  jassert(tempBuffer.getNumSamples() >= numSamples);
+  const int numChannels = juce::jmin(buffer->getNumChannels(), 2);
 
-  // Resize to actual block size so DSP processes the correct number of samples.
-  // avoidReallocating=true ensures no allocation on the audio thread.
-  tempBuffer.setSize(2, numSamples, false, false, true);
-  dryBuffer.setSize(2, numSamples, false, false, true);
-  tempBuffer.clear();
+  profiler.beginCallback();
 
   if (playbackState == PlaybackState::PLAYING && readerSource != nullptr) {
     // --- FILE PLAYBACK PATH ---
+    ScopedStageTimer timer(&profiler, ProfileStage::INPUT);
     transportSource.getNextAudioBlock(bufferToFill);
-
-    for (int ch = 0; ch < 2; ++ch) {
-      // Read from device buffer if channel exists, otherwise duplicate ch 0
-      int srcCh = (ch < numChannels) ? ch : 0;
-      auto *channelData = buffer->getReadPointer(srcCh, bufferToFill.startSample);
-
-      float peak = 0.0f;
-      for (int i = 0; i < numSamples; ++i)
-        peak = juce::jmax(peak, std::abs(channelData[i]));
-      inputLevel[ch] = peak;
-
-      tempBuffer.copyFrom(ch, 0, channelData, numSamples);
-    }
-  } else {
-    // --- MIC INPUT PATH ---
-    for (int ch = 0; ch < 2; ++ch) {
-      int srcCh = (ch < numChannels) ? ch : 0;
-      auto *channelData = buffer->getReadPointer(srcCh, bufferToFill.startSample);
-
-      float peak = 0.0f;
-      for (int i = 0; i < numSamples; ++i)
-        peak = juce::jmax(peak, std::abs(channelData[i]));
-      inputLevel[ch] = peak;
-
-      tempBuffer.copyFrom(ch, 0, channelData, numSamples);
-    }
   }
-
-  // Store dry copy for wet/dry mix
-  for (int ch = 0; ch < 2; ++ch)
-    dryBuffer.copyFrom(ch, 0, tempBuffer, ch, 0, numSamples);
+  // --- MIC INPUT PATH: the device input is already in the buffer ---
 
   // Measure CPU usage around DSP processing
   auto cpuStart = juce::Time::getHighResolutionTicks();
 
-  // Process through DSP (always stereo internally)
-  dsp.processBlock(tempBuffer);
-
-  // Apply wet/dry mix
-  float mix = mixValue.load(std::memory_order_relaxed);
-  if (mix < 1.0f) {
-    float dryGain = 1.0f - mix;
-    for (int ch = 0; ch < 2; ++ch) {
-      auto *wet = tempBuffer.getWritePointer(ch);
-      auto *dry = dryBuffer.getReadPointer(ch);
-      for (int i = 0; i < numSamples; ++i)
-        wet[i] = wet[i] * mix + dry[i] * dryGain;
-    }
-  }
+  // The DSP processes the first two device channels in place (a mono device
+  // gets one) and meters input and output in its own passes, including the
+  // latency-aligned wet/dry mix: one read and one write per sample.
+  // Referring to the device channels doesn't allocate.
+  juce::AudioBuffer<float> deviceBlock(buffer->getArrayOfWritePointers(), numChannels,
+                                       bufferToFill.startSample, numSamples);
+  dsp.processBlock(deviceBlock);
 
   auto cpuEnd = juce::Time::getHighResolutionTicks();
   double elapsedSec = juce::Time::highResolutionTicksToSeconds(cpuEnd - cpuStart);
@@ -448,18 +453,16 @@ void MainComponent::getNextAudioBlock(
     cpuLoad.store(prev * 0.9f + load * 0.1f, std::memory_order_relaxed);
   }
 
-  // Meter output levels (always both channels)
+  // Both meters always show; a mono device drives them from its one channel
   for (int ch = 0; ch < 2; ++ch) {
-    auto *processed = tempBuffer.getReadPointer(ch);
-    float peak = 0.0f;
-    for (int i = 0; i < numSamples; ++i)
-      peak = juce::jmax(peak, std::abs(processed[i]));
-    outputLevel[ch] = peak;
+    const int meteredCh = juce::jmin(ch, numChannels - 1);
+    inputLevel[ch] = numChannels > 0 ? dsp.getInputLevel(meteredCh) : 0.0f;
+    outputLevel[ch] = numChannels > 0 ? dsp.getOutputLevel(meteredCh) : 0.0f;
   }
 
-  // Copy back to device output buffer
-  for (int ch = 0; ch < juce::jmin(numChannels, 2); ++ch)
-    buffer->copyFrom(ch, bufferToFill.startSample, tempBuffer, ch, 0, numSamples);
+  profiler.endCallback();
+  callbackMonitor.record(juce::Time::getHighResolutionTicks() - callbackStart, numSamples,
+                         deviceSampleRate);
 }
 
 void MainComponent::releaseResources() {
@@ -557,21 +560,39 @@ void MainComponent::paint(juce::Graphics &g) {
     g.setColour(juce::Colour(0xff3a3a3a));
     g.drawRect(waveformArea);
 
-    if (thumbnail.getTotalLength() > 0.0) {
-      g.setColour(juce::Colour(0xff44aa44));
-      thumbnail.drawChannels(g, waveformArea.reduced(2),
-                             0.0, thumbnail.getTotalLength(), 1.0f);
+    if (waveformPeaks.isReady()) {
+      const auto view = getWaveformView();
+      waveformPeaks.drawChannels(g, waveformArea.reduced(2), view.getStart(), view.getEnd(),
+                                 juce::Colour(0xff44aa44), juce::Colour(0xff66cc66));
+      processedWaveform.drawChannels(g, waveformArea.reduced(2), view.getStart(), view.getEnd(),
+                                     juce::Colour(0x99e0a040), juce::Colour(0xccff4030));
+
+      const double overlayProgress = processedWaveform.getProgress();
+      if (overlayProgress < 1.0) {
+        g.setColour(juce::Colours::lightgrey);
+        g.setFont(9.0f);
+        g.drawText("Processing " + juce::String((int)(overlayProgress * 100)) + "%",
+                   waveformArea.reduced(4), juce::Justification::topRight);
+      }
 
-      // Draw playback position
+      // Draw playback position when it is inside the view
       if (transportSource.getLengthInSeconds() > 0.0) {
-        double posRatio = transportSource.getCurrentPosition()
-                        / transportSource.getLengthInSeconds();
-        int xPos = waveformArea.getX() + 2
-                 + (int)(posRatio * (waveformArea.getWidth() - 4));
-        g.setColour(juce::Colours::white);
-        g.drawLine((float)xPos, (float)waveformArea.getY(),
-                   (float)xPos, (float)waveformArea.getBottom(), 2.0f);
+        const double position =
+            transportSource.getCurrentPosition() * waveformPeaks.getSampleRate();
+        const double posRatio = (position - (double)view.getStart()) / (double)view.getLength();
+        if (posRatio >= 0.0 && posRatio <= 1.0) {
+          int xPos = waveformArea.getX() + 2
+                   + (int)(posRatio * (waveformArea.getWidth() - 4));
+          g.setColour(juce::Colours::white);
+          g.drawLine((float)xPos, (float)waveformArea.getY(),
+                     (float)xPos, (float)waveformArea.getBottom(), 2.0f);
+        }
       }
+    } else if (waveformPeaks.isBuilding()) {
+      g.setColour(juce::Colours::grey);
+      const int percent = (int)(waveformPeaks.getBuildProgress() * 100);
+      g.drawText("Scanning waveform " + juce::String(percent) + "%", waveformArea,
+                 juce::Justification::centred);
     } else {
       g.setColour(juce::Colours::grey);
       g.drawText("No file loaded", waveformArea, juce::Justification::centred);
@@ -622,7 +643,11 @@ void MainComponent::resized() {
   rightPanel.removeFromTop(8);
 
   // Status log
-  statusLogLabel.setBounds(rightPanel.removeFromTop(18));
+  auto statusLogRow = rightPanel.removeFromTop(18);
+  dumpTimingButton.setBounds(statusLogRow.removeFromRight(50));
+  statusLogRow.removeFromRight(4);
+  stagesButton.setBounds(statusLogRow.removeFromRight(60));
+  statusLogLabel.setBounds(statusLogRow);
   rightPanel.removeFromTop(3);
   statusLog.setBounds(rightPanel.removeFromTop(110));
   rightPanel.removeFromTop(8);
@@ -647,8 +672,13 @@ void MainComponent::resized() {
   loopToggle.setBounds(transportRow.removeFromLeft(65));
   rightPanel.removeFromTop(6);
 
-  // Export button + output location + progress
-  exportButton.setBounds(rightPanel.removeFromTop(32));
+  // Export buttons + output location + progress
+  auto exportRow = rightPanel.removeFromTop(32);
+  batchExportButton.setBounds(exportRow.removeFromRight(90));
+  exportRow.removeFromRight(5);
+  parallelExportToggle.setBounds(exportRow.removeFromLeft(85));
+  exportRow.removeFromLeft(5);
+  exportButton.setBounds(exportRow);
   rightPanel.removeFromTop(3);
   outputLocationLabel.setBounds(rightPanel.removeFromTop(14));
   rightPanel.removeFromTop(4);
@@ -717,8 +747,10 @@ void MainComponent::resized() {
   mixSlider.setBounds(mixBounds);
   helpMix.setBounds(mixBounds.getRight() - helpSize, mixBounds.getY(), helpSize, helpSize);
 
-  // Latency label at bottom
-  latencyLabel.setBounds(controlArea.removeFromBottom(22));
+  // Low-latency toggle and latency label at bottom
+  auto latencyRow = controlArea.removeFromBottom(22);
+  lowLatencyButton.setBounds(latencyRow.removeFromLeft(120));
+  latencyLabel.setBounds(latencyRow);
 }
 
 void MainComponent::timerCallback() {
@@ -728,6 +760,24 @@ void MainComponent::timerCallback() {
 
   if (!waveformArea.isEmpty())
     repaint(waveformArea);
+
+  // Re-render the overlay from the visible range whenever the sound changes
+  processedWaveform.setFocus(getWaveformView().getStart());
+  processedWaveform.setSettings(getCurrentRenderSettings());
+
+  // Deadline figures in the latency label about once a second, and right
+  // away once the audio thread has switched latency mode
+  if (++timerTicks % 30 == 0 || dsp.getLatencySamples() != displayedLatency) {
+    callbackMonitor.collectMisses();
+    updateLatencyDisplay();
+  }
+
+  if (batchRenderer != nullptr && batchRenderer->isRunning()) {
+    progress = batchRenderer->getTotalProgress();
+    progressBar.setTextToDisplay("Batch " + juce::String(batchRenderer->getNumFinishedJobs()) +
+                                 "/" + juce::String(batchRenderer->getNumJobs()) + " (" +
+                                 juce::String(batchRenderer->getRealtimeFactor(), 1) + "x RT)");
+  }
 }
 
 void MainComponent::mouseDown(const juce::MouseEvent &e) {
@@ -740,10 +790,49 @@ void MainComponent::mouseDown(const juce::MouseEvent &e) {
   if (waveformArea.contains(e.getPosition()) && transportSource.getLengthInSeconds() > 0.0) {
     double clickRatio = (double)(e.x - waveformArea.getX()) / waveformArea.getWidth();
     clickRatio = juce::jlimit(0.0, 1.0, clickRatio);
-    transportSource.setPosition(clickRatio * transportSource.getLengthInSeconds());
+    if (waveformPeaks.isReady()) {
+      const auto view = getWaveformView();
+      transportSource.setPosition(((double)view.getStart() + clickRatio * (double)view.getLength())
+                                  / waveformPeaks.getSampleRate());
+    } else {
+      transportSource.setPosition(clickRatio * transportSource.getLengthInSeconds());
+    }
   }
 }
 
+void MainComponent::mouseWheelMove(const juce::MouseEvent &e, const juce::MouseWheelDetails &wheel) {
+  if (!waveformArea.contains(e.getPosition()) || !waveformPeaks.isReady())
+    return;
+
+  // Vertical wheel zooms around the cursor, horizontal pans; the closest
+  // zoom still shows one finest-level bucket per pixel
+  const auto length = waveformPeaks.getLengthInSamples();
+  const auto view = getWaveformView();
+  const double cursorRatio =
+      juce::jlimit(0.0, 1.0, (double)(e.x - waveformArea.getX()) / waveformArea.getWidth());
+  const auto minLength =
+      juce::jmin(length, (juce::int64)waveformArea.getWidth() * PeakLevels::samplesPerBucket);
+
+  const auto zoomed = (double)view.getLength() * std::pow(2.0, -wheel.deltaY * 4.0);
+  const auto newLength = juce::jlimit(minLength, length, (juce::int64)zoomed);
+  auto newStart = view.getStart()
+                + (juce::int64)(cursorRatio * (double)(view.getLength() - newLength))
+                - (juce::int64)(wheel.deltaX * (double)newLength);
+  newStart = juce::jlimit((juce::int64)0, length - newLength, newStart);
+
+  if (newLength >= length)
+    waveformView = {};
+  else
+    waveformView = { newStart, newStart + newLength };
+  repaint(waveformArea);
+}
+
+juce::Range<juce::int64> MainComponent::getWaveformView() const {
+  if (waveformView.isEmpty())
+    return { 0, waveformPeaks.getLengthInSamples() };
+  return waveformView;
+}
+
 void MainComponent::showHelp(juce::Component *anchor, const juce::String &text) {
   if (activeBubble != nullptr) {
     activeBubble->dismiss();
@@ -766,8 +855,36 @@ void MainComponent::setHelpButtonsVisible(bool visible) {
 
 void MainComponent::updateLatencyDisplay() {
   int latencySamples = dsp.getLatencySamples();
-  latencyLabel.setText("Latency: " + juce::String(latencySamples) + " | Phase Shifter",
-                       juce::dontSendNotification);
+  displayedLatency = latencySamples;
+  juce::String text = "Latency: " + juce::String(latencySamples) +
+                      (dsp.isLowLatency() ? " (IIR)" : "") + " | Phase Shifter";
+
+  // Callback duration against the buffer period
+  const auto stats = callbackMonitor.getHistogram().getStats();
+  if (stats.count > 0)
+    text << " | Callback p99.9 " << juce::String(stats.p999Us * 1.0e-3, 2) << " ms, worst "
+         << juce::String(stats.maxUs * 1.0e-3, 2) << " / "
+         << juce::String(callbackMonitor.getBudgetUs() * 1.0e-3, 2) << " ms | Misses "
+         << juce::String((juce::int64)callbackMonitor.getNumMisses());
+
+  latencyLabel.setText(text, juce::dontSendNotification);
+}
+
+void MainComponent::dumpCallbackTiming() {
+  juce::String header = "Neve Transformer callback timing, " +
+                        juce::Time::getCurrentTime().toString(true, true) + "\n";
+  if (auto *device = deviceManager.getCurrentAudioDevice())
+    header << "Device: " << device->getName() << ", "
+           << juce::String(device->getCurrentSampleRate(), 0) << " Hz, "
+           << juce::String(device->getCurrentBufferSizeSamples()) << " smp\n";
+  header << "\n" << profiler.getSummary();
+
+  auto file = getOutputFile("callback_timing", ".txt");
+  statusLog.moveCaretToEnd();
+  if (callbackMonitor.dumpToFile(file, header))
+    statusLog.insertTextAtCaret("Timing dump: " + file.getFileName() + "\n");
+  else
+    statusLog.insertTextAtCaret("[ERROR] Cannot write: " + file.getFullPathName() + "\n");
 }
 
 void MainComponent::updatePresetSelector() {
@@ -796,12 +913,8 @@ void MainComponent::loadPreset(int index) {
   modeButton.setToggleState(preset.micMode, juce::dontSendNotification);
   zLoadButton.setToggleState(preset.hiZLoad, juce::dontSendNotification);
 
-  dsp.setDrive(preset.drive);
-  dsp.setIron(preset.iron);
-  dsp.setHFRoll(preset.hfRoll);
-  dsp.setMode(preset.micMode);
-  dsp.setZLoad(preset.hiZLoad);
-  mixValue.store(preset.mix, std::memory_order_relaxed);
+  // One command, so the engine never runs a mix of old and new settings
+  dsp.setParameters({ preset.drive, preset.iron, preset.hfRoll, preset.micMode, preset.hiZLoad, preset.mix });
 }
 
 void MainComponent::saveCurrentPreset() {
@@ -921,7 +1034,11 @@ void MainComponent::loadFileForPreview(const juce::File &file) {
   transportSource.setSource(readerSource.get(), 0, nullptr,
                              reader->sampleRate, (int)reader->numChannels);
 
-  thumbnail.setSource(new juce::FileInputSource(file));
+  waveformPeaks.setSource(file);
+  waveformView = {};
+  processedWaveform.setFocus(0);
+  processedWaveform.setSettings(getCurrentRenderSettings());
+  processedWaveform.setSource(file);
 
   inputFile = file;
   fileNameLabel.setText(file.getFileName(), juce::dontSendNotification);
@@ -962,6 +1079,12 @@ juce::File MainComponent::getOutputDirectory() {
                     "Egna projekt/herrstrom");
 }
 
+juce::File MainComponent::getPeakCacheDirectory() {
+  return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+      .getChildFile("Neve Transformer")
+      .getChildFile("PeakCache");
+}
+
 juce::File MainComponent::getOutputFile(const juce::String &originalName,
                                          const juce::String &extension) {
   auto outputDir = getOutputDirectory();
@@ -982,9 +1105,7 @@ void MainComponent::exportProcessedFile() {
   if (!inputFile.existsAsFile()) return;
 
   // Determine output format from input extension
-  juce::String ext = inputFile.getFileExtension().toLowerCase();
-  if (ext != ".aiff" && ext != ".aif")
-    ext = ".wav";
+  juce::String ext = OfflineRenderer::getOutputExtensionFor(inputFile);
 
   juce::String baseName = inputFile.getFileNameWithoutExtension();
   juce::File outFile = getOutputFile(baseName, ext);
@@ -1002,155 +1123,147 @@ void MainComponent::exportProcessedFile() {
   statusLog.insertTextAtCaret("Input: " + inputFile.getFileName() + "\n");
   statusLog.insertTextAtCaret("Output: " + outFile.getFileName() + "\n");
 
-  // Capture current parameters
-  double drive = driveSlider.getValue();
-  double iron = ironSlider.getValue();
-  double hfRoll = hfRollSlider.getValue();
-  bool mode = modeButton.getToggleState();
-  bool zLoad = zLoadButton.getToggleState();
-  bool bypassed = bypassButton.getToggleState();
-  float mix = (float)mixSlider.getValue();
-
-  auto startTime = juce::Time::getMillisecondCounterHiRes();
+  // Capture current parameters; with PARALLEL on, long files are split
+  // across all cores
+  RenderSettings settings = getCurrentRenderSettings();
+  settings.maxSegments = parallelExportToggle.getToggleState() ? juce::SystemStats::getNumCpus() : 1;
 
-  juce::Thread::launch([this, drive, iron, hfRoll, mode, zLoad, bypassed,
-                        mix, outFile, ext, startTime] {
-    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(inputFile));
+  juce::Thread::launch([this, settings, outFile] {
+    OfflineRenderer renderer(formatManager);
+    auto result = renderer.render(inputFile, outFile, settings,
+                                  [this](double p) { progress = p; });
 
-    if (reader == nullptr) {
-      juce::MessageManager::callAsync([this] {
-        statusLog.insertTextAtCaret("[ERROR] Could not read input file\n");
+    juce::MessageManager::callAsync([this, result] {
+      if (result.samplesProcessed == 0 && !result.succeeded) {
+        statusLog.insertTextAtCaret("[ERROR] " + result.error + "\n");
         exportButton.setEnabled(true);
         selectInputButton.setEnabled(true);
-      });
-      return;
-    }
+        return;
+      }
 
-    double fileDuration = (double)reader->lengthInSamples / reader->sampleRate;
-    juce::MessageManager::callAsync([this, fileDuration] {
-      statusLog.insertTextAtCaret("Duration: " + juce::String(fileDuration, 1) + "s\n");
-    });
+      statusLog.insertTextAtCaret("Duration: " +
+          juce::String((double)result.totalSamples / result.sampleRate, 1) + "s\n");
 
-    if (outFile.existsAsFile())
-      outFile.deleteFile();
+      if (!result.succeeded)
+        statusLog.insertTextAtCaret("[ERROR] " + result.error + "\n");
 
-    // Choose format based on extension
-    std::unique_ptr<juce::AudioFormat> format;
-    if (ext == ".aiff" || ext == ".aif")
-      format = std::make_unique<juce::AiffAudioFormat>();
-    else
-      format = std::make_unique<juce::WavAudioFormat>();
+      if (result.numSegments > 1)
+        statusLog.insertTextAtCaret(juce::String(result.numSegments) + " segments, boundary mismatch " +
+            juce::String(juce::Decibels::gainToDecibels(result.maxSegmentDeviation), 1) + " dB\n");
 
-    auto *outStream = outFile.createOutputStream().release();
+      statusLog.insertTextAtCaret(
+          juce::String(result.samplesProcessed) + "/" + juce::String(result.totalSamples) +
+          " samples (" + juce::String((result.samplesProcessed * 100.0) / result.totalSamples, 1) + "%)\n");
 
-    if (outStream == nullptr) {
-      juce::MessageManager::callAsync([this] {
-        statusLog.insertTextAtCaret("[ERROR] Could not create output stream\n");
-        exportButton.setEnabled(true);
-        selectInputButton.setEnabled(true);
-      });
-      return;
-    }
+      statusLog.insertTextAtCaret(
+          juce::String(result.getAudioSeconds(), 1) + "s in " + juce::String(result.wallSeconds, 2) +
+          "s (" + juce::String(result.getRealtimeFactor(), 1) + "x RT)\n");
+      statusLog.insertTextAtCaret("--- Export complete ---\n\n");
+      progressBar.setTextToDisplay("Done!");
+      exportButton.setEnabled(true);
+      selectInputButton.setEnabled(true);
+    });
+  });
+}
 
-    std::unique_ptr<juce::AudioFormatWriter> writer(
-        format->createWriterFor(outStream,
-                                reader->sampleRate,
-                                (unsigned int)reader->numChannels,
-                                (unsigned int)reader->bitsPerSample,
-                                {},
-                                0));
-
-    if (writer == nullptr) {
-      juce::MessageManager::callAsync([this] {
-        statusLog.insertTextAtCaret("[ERROR] Could not create output writer\n");
-        exportButton.setEnabled(true);
-        selectInputButton.setEnabled(true);
-      });
-      return;
-    }
+RenderSettings MainComponent::getCurrentRenderSettings() const {
+  RenderSettings settings;
+  settings.drive = driveSlider.getValue();
+  settings.iron = ironSlider.getValue();
+  settings.hfRoll = hfRollSlider.getValue();
+  settings.micMode = modeButton.getToggleState();
+  settings.hiZLoad = zLoadButton.getToggleState();
+  settings.bypassed = bypassButton.getToggleState();
+  settings.mix = (float)mixSlider.getValue();
+  return settings;
+}
 
-    NeveTransformerDSP fileDsp;
-    fileDsp.prepare(reader->sampleRate, 4096);
-    fileDsp.setDrive(drive);
-    fileDsp.setIron(iron);
-    fileDsp.setHFRoll(hfRoll);
-    fileDsp.setMode(mode);
-    fileDsp.setZLoad(zLoad);
-    fileDsp.setBypassed(bypassed);
-
-    const int blockSize = 4096;
-    juce::AudioBuffer<float> buf((int)reader->numChannels, blockSize);
-    juce::AudioBuffer<float> dryBuf((int)reader->numChannels, blockSize);
-    int64_t samplesProcessed = 0;
-
-    while (samplesProcessed < reader->lengthInSamples) {
-      int numToRead = (int)juce::jmin((int64_t)blockSize,
-                                       reader->lengthInSamples - samplesProcessed);
-
-      buf.setSize((int)reader->numChannels, numToRead, false, false, false);
-      dryBuf.setSize((int)reader->numChannels, numToRead, false, false, false);
-
-      bool hasRight = reader->numChannels > 1;
-      if (!reader->read(&buf, 0, numToRead, samplesProcessed, true, hasRight)) {
-        juce::MessageManager::callAsync([this, samplesProcessed] {
-          statusLog.insertTextAtCaret("[ERROR] Read failure at sample " +
-                                     juce::String(samplesProcessed) + "\n");
-        });
-        break;
-      }
+// --- Batch Export ---
 
-      // Store dry copy
-      for (int ch = 0; ch < buf.getNumChannels(); ++ch)
-        dryBuf.copyFrom(ch, 0, buf, ch, 0, numToRead);
+void MainComponent::selectBatchInput() {
+  fileChooser = std::make_unique<juce::FileChooser>(
+      "Select audio files or a folder...",
+      juce::File::getSpecialLocation(juce::File::userHomeDirectory),
+      "*.wav;*.aiff;*.aif");
 
-      fileDsp.processBlock(buf);
+  auto flags = juce::FileBrowserComponent::openMode
+             | juce::FileBrowserComponent::canSelectFiles
+             | juce::FileBrowserComponent::canSelectDirectories
+             | juce::FileBrowserComponent::canSelectMultipleItems;
 
-      // Apply wet/dry mix
-      if (mix < 1.0f) {
-        float dryGain = 1.0f - mix;
-        for (int ch = 0; ch < buf.getNumChannels(); ++ch) {
-          auto *wet = buf.getWritePointer(ch);
-          auto *dry = dryBuf.getReadPointer(ch);
-          for (int i = 0; i < numToRead; ++i)
-            wet[i] = wet[i] * mix + dry[i] * dryGain;
-        }
-      }
+  fileChooser->launchAsync(flags, [this](const juce::FileChooser &fc) {
+    auto files = BatchRenderer::collectAudioFiles(fc.getResults());
+    if (!files.isEmpty())
+      startBatchExport(files);
+  });
+}
 
-      if (!writer->writeFromAudioSampleBuffer(buf, 0, numToRead)) {
-        juce::MessageManager::callAsync([this] {
-          statusLog.insertTextAtCaret("[ERROR] Failed to write output\n");
-        });
-        break;
-      }
+void MainComponent::startBatchExport(const juce::Array<juce::File> &files) {
+  if (batchRenderer == nullptr) {
+    batchRenderer = std::make_unique<BatchRenderer>(formatManager,
+                                                    juce::SystemStats::getNumCpus());
+
+    batchRenderer->onJobFinished = [this](const RenderResult &result) {
+      juce::MessageManager::callAsync([this, result] {
+        statusLog.moveCaretToEnd();
+        if (result.succeeded)
+          statusLog.insertTextAtCaret(result.inputFile.getFileName() + ": " +
+              juce::String(result.getRealtimeFactor(), 1) + "x RT\n");
+        else
+          statusLog.insertTextAtCaret("[ERROR] " + result.inputFile.getFileName() +
+                                      ": " + result.error + "\n");
+      });
+    };
 
-      samplesProcessed += numToRead;
-      progress = (double)samplesProcessed / (double)reader->lengthInSamples;
-    }
+    batchRenderer->onBatchFinished = [this] {
+      juce::MessageManager::callAsync([this] { batchExportFinished(); });
+    };
+  }
 
-    int64_t totalSamples = reader->lengthInSamples;
-    double finalSampleRate = reader->sampleRate;
-    writer.reset();
-    reader.reset();
+  juce::Array<BatchRenderer::Item> items;
+  for (const auto &file : files) {
+    auto ext = OfflineRenderer::getOutputExtensionFor(file);
+    auto outFile = getOutputFile(file.getFileNameWithoutExtension(), ext)
+                       .getNonexistentSibling(false);
+    items.add({ file, outFile });
+  }
 
-    juce::MessageManager::callAsync([this, samplesProcessed, totalSamples,
-                                     finalSampleRate, startTime] {
-      auto endTime = juce::Time::getMillisecondCounterHiRes();
-      double elapsedSec = (endTime - startTime) / 1000.0;
-      double audioSec = (double)samplesProcessed / finalSampleRate;
+  if (!batchRenderer->start(items, getCurrentRenderSettings()))
+    return;
 
-      statusLog.insertTextAtCaret(
-          juce::String(samplesProcessed) + "/" + juce::String(totalSamples) +
-          " samples (" + juce::String((samplesProcessed * 100.0) / totalSamples, 1) + "%)\n");
+  exportButton.setEnabled(false);
+  batchExportButton.setButtonText("CANCEL");
+  progress = 0.0;
+  progressBar.setTextToDisplay("Batch 0/" + juce::String(items.size()));
 
-      statusLog.insertTextAtCaret(
-          juce::String(audioSec, 1) + "s in " + juce::String(elapsedSec, 2) +
-          "s (" + juce::String(audioSec / elapsedSec, 1) + "x RT)\n");
-      statusLog.insertTextAtCaret("--- Export complete ---\n\n");
-      progressBar.setTextToDisplay("Done!");
-      exportButton.setEnabled(true);
-      selectInputButton.setEnabled(true);
-    });
-  });
+  statusLog.moveCaretToEnd();
+  statusLog.insertTextAtCaret("\n--- Batch export: " + juce::String(items.size()) +
+                              " files on " + juce::String(batchRenderer->getNumThreads()) +
+                              " threads ---\n");
+}
+
+void MainComponent::batchExportFinished() {
+  if (batchRenderer == nullptr || batchRenderer->isRunning())
+    return;
+
+  int failed = 0;
+  for (const auto &result : batchRenderer->getResults())
+    if (!result.succeeded)
+      ++failed;
+
+  statusLog.moveCaretToEnd();
+  statusLog.insertTextAtCaret(
+      juce::String(batchRenderer->getNumJobs() - failed) + "/" +
+      juce::String(batchRenderer->getNumJobs()) + " files, " +
+      juce::String(batchRenderer->getRenderedAudioSeconds(), 1) + "s in " +
+      juce::String(batchRenderer->getElapsedSeconds(), 2) + "s (" +
+      juce::String(batchRenderer->getRealtimeFactor(), 1) + "x RT)\n");
+  statusLog.insertTextAtCaret("--- Batch complete ---\n\n");
+
+  progress = 1.0;
+  progressBar.setTextToDisplay(failed == 0 ? "Done!" : juce::String(failed) + " failed");
+  batchExportButton.setButtonText("BATCH...");
+  exportButton.setEnabled(inputFile.existsAsFile());
 }
 
 // --- A/B Comparison ---
@@ -1174,10 +1287,6 @@ void MainComponent::loadSnapshot(bool isA) {
   modeButton.setToggleState(snap.micMode, juce::dontSendNotification);
   zLoadButton.setToggleState(snap.hiZLoad, juce::dontSendNotification);
 
-  dsp.setDrive(snap.drive);
-  dsp.setIron(snap.iron);
-  dsp.setHFRoll(snap.hfRoll);
-  dsp.setMode(snap.micMode);
-  dsp.setZLoad(snap.hiZLoad);
-  mixValue.store(snap.mix, std::memory_order_relaxed);
+  // One command, so the engine never runs a mix of old and new settings
+  dsp.setParameters({ snap.drive, snap.iron, snap.hfRoll, snap.micMode, snap.hiZLoad, snap.mix });
 }
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "../DSP/NeveTransformerDSP.h"
+#include "../Render/BatchRenderer.h"
+#include "../Render/OfflineRenderer.h"
+#include "CallbackMonitor.h"
 #include "NeveLookAndFeel.h"
+#include "PeakPyramid.h"
+#include "ProcessedWaveform.h"
 #include "PresetManager.h"
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_audio_utils/juce_audio_utils.h>
@@ -82,10 +87,11 @@ public:
   void resized() override;
   void timerCallback() override;
   void mouseDown(const juce::MouseEvent &e) override;
+  void mouseWheelMove(const juce::MouseEvent &e, const juce::MouseWheelDetails &wheel) override;
 
 private:
-  // DSP processor
-  NeveTransformerDSP dsp;
+  // DSP processor: float engine for live playback, exports render in double
+  NeveTransformerDSPFloat dsp;
 
   // Custom styling
   NeveLookAndFeel neveLookAndFeel;
@@ -104,12 +110,12 @@ private:
   // Wet/Dry mix
   juce::Slider mixSlider;
   juce::Label mixLabel;
-  std::atomic<float> mixValue { 1.0f };
 
   // Toggle buttons
   juce::ToggleButton modeButton;
   juce::ToggleButton zLoadButton;
   juce::ToggleButton bypassButton;
+  juce::ToggleButton lowLatencyButton;
 
   // A/B comparison
   juce::TextButton abButton;
@@ -137,10 +143,14 @@ private:
   // Status log
   juce::TextEditor statusLog;
   juce::Label statusLogLabel;
+  juce::TextButton stagesButton;
+  juce::TextButton dumpTimingButton;
 
   // File / Transport UI
   juce::TextButton selectInputButton;
   juce::TextButton exportButton;
+  juce::TextButton batchExportButton;
+  juce::ToggleButton parallelExportToggle; // segmented export of long files
   juce::Label fileProcessingLabel;
   juce::Label fileNameLabel;
   juce::Label outputLocationLabel;
@@ -161,8 +171,6 @@ private:
   // File playback source chain
   std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
   juce::AudioTransportSource transportSource;
-  juce::AudioThumbnailCache thumbnailCache { 5 };
-  juce::AudioThumbnail thumbnail;
 
   // File members
   juce::File inputFile;
@@ -170,6 +178,18 @@ private:
   juce::AudioFormatManager formatManager;
   double progress = 0.0;
 
+  // Waveform overview (cached on disk by content) and the zoomed range in
+  // source samples; an empty range shows the whole file
+  PeakPyramid waveformPeaks;
+  juce::Range<juce::int64> waveformView;
+  juce::Range<juce::int64> getWaveformView() const;
+
+  // The same file rendered with the current settings, drawn over it
+  ProcessedWaveform processedWaveform { formatManager };
+
+  // Multi-file export (one DSP instance per job on a fixed thread pool)
+  std::unique_ptr<BatchRenderer> batchRenderer;
+
   // Level meters
   std::atomic<float> inputLevel[2];
   std::atomic<float> outputLevel[2];
@@ -177,12 +197,18 @@ private:
   // CPU meter
   std::atomic<float> cpuLoad { 0.0f };
 
-  // Pre-allocated buffers for audio thread
-  juce::AudioBuffer<float> tempBuffer;
-  juce::AudioBuffer<float> dryBuffer;
+  // Per-stage timings of the audio callback (DSP stages filled in by dsp)
+  StageProfiler profiler;
+
+  // Whole-callback duration against the device buffer period
+  CallbackMonitor callbackMonitor;
+  double deviceSampleRate = 0.0;
+  int timerTicks = 0;
+  int displayedLatency = -1;
 
   // Fixed output directory
   static juce::File getOutputDirectory();
+  static juce::File getPeakCacheDirectory();
   juce::File getOutputFile(const juce::String &originalName, const juce::String &extension);
 
   // Help system
@@ -194,6 +220,7 @@ private:
   void setHelpButtonsVisible(bool visible);
 
   void updateLatencyDisplay();
+  void dumpCallbackTiming();
   void loadPreset(int index);
   void saveCurrentPreset();
   void updatePresetSelector();
@@ -204,6 +231,10 @@ private:
   void startPlayback();
   void stopPlayback();
   void exportProcessedFile();
+  RenderSettings getCurrentRenderSettings() const;
+  void selectBatchInput();
+  void startBatchExport(const juce::Array<juce::File> &files);
+  void batchExportFinished();
   void captureSnapshot(bool isA);
   void loadSnapshot(bool isA);
 
@@ -0,0 +1,504 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * Min/max/RMS buckets of an audio stream at every resolution: level 0 holds
+ * one bucket per samplesPerBucket samples and every further level merges
+ * levelFactor buckets, so any range is summarised from a handful of reads.
+ * Either built in memory, level 0 first, or mapped from a stored file.
+ */
+class PeakLevels {
+public:
+  static constexpr int samplesPerBucket = 256;
+  static constexpr int levelFactor = 4;
+
+  struct Peak {
+    float min = 0.0f, max = 0.0f, rms = 0.0f;
+  };
+
+  // One bucket of one channel, full scale = 32767
+  struct Bucket {
+    juce::int16 min, max, rms;
+
+    static Bucket fromSamples(const float *samples, int numSamples) {
+      float min = samples[0], max = samples[0], sumSquares = 0.0f;
+      for (int i = 0; i < numSamples; ++i) {
+        min = juce::jmin(min, samples[i]);
+        max = juce::jmax(max, samples[i]);
+        sumSquares += samples[i] * samples[i];
+      }
+      return { quantise(min), quantise(max), quantise(std::sqrt(sumSquares / (float)numSamples)) };
+    }
+
+    static juce::int16 quantise(float value) {
+      return (juce::int16)juce::roundToInt(juce::jlimit(-1.0f, 1.0f, value) * 32767.0f);
+    }
+  };
+
+  /** Zeroed in-memory levels for a stream of this length */
+  PeakLevels(juce::int64 lengthInSamples, int numChannels, double sampleRate,
+             juce::uint64 contentHash = 0) {
+    header.numChannels = numChannels;
+    header.contentHash = contentHash;
+    header.lengthInSamples = lengthInSamples;
+    header.sampleRate = sampleRate;
+    setLayout(header);
+    storage.resize(getNumStoredBuckets(), Bucket { 0, 0, 0 });
+    buckets = storage.data();
+  }
+
+  /** Maps a file written by store(); nullptr if missing, damaged or for other content */
+  static std::unique_ptr<PeakLevels> load(const juce::File &file, juce::uint64 contentHash) {
+    if (!file.existsAsFile())
+      return nullptr;
+    std::unique_ptr<PeakLevels> levels(new PeakLevels());
+    levels->mappedFile =
+        std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto *data = static_cast<const char *>(levels->mappedFile->getData());
+    const auto size = levels->mappedFile->getSize();
+    if (data == nullptr || size < sizeof(Header))
+      return nullptr;
+
+    std::memcpy(&levels->header, data, sizeof(Header));
+    const auto &header = levels->header;
+    Header expected;
+    if (std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) != 0 ||
+        header.contentHash != contentHash || header.numChannels <= 0 ||
+        header.lengthInSamples <= 0)
+      return nullptr;
+
+    // Every level where this length puts it, and exactly the data they need
+    expected.lengthInSamples = header.lengthInSamples;
+    setLayout(expected);
+    if (header.numLevels != expected.numLevels ||
+        std::memcmp(header.levelStart, expected.levelStart, sizeof(expected.levelStart)) != 0 ||
+        std::memcmp(header.levelSize, expected.levelSize, sizeof(expected.levelSize)) != 0)
+      return nullptr;
+    if (sizeof(Header) + levels->getNumStoredBuckets() * sizeof(Bucket) != size)
+      return nullptr;
+
+    levels->buckets = reinterpret_cast<const Bucket *>(data + sizeof(Header));
+    return levels;
+  }
+
+  /**
+   * Written to a temporary file and moved into place, so load() never maps
+   * a partial file
+   */
+  bool store(const juce::File &file) const {
+    if (!file.getParentDirectory().createDirectory())
+      return false;
+    const auto temp = file.getSiblingFile(file.getFileName() + ".tmp");
+    temp.deleteFile();
+    {
+      auto stream = temp.createOutputStream();
+      if (stream == nullptr || !stream->write(&header, sizeof(Header)) ||
+          !stream->write(buckets, getNumStoredBuckets() * sizeof(Bucket))) {
+        stream.reset();
+        temp.deleteFile();
+        return false;
+      }
+    }
+    return temp.moveFileTo(file);
+  }
+
+  int getNumChannels() const { return header.numChannels; }
+  juce::int64 getLengthInSamples() const { return header.lengthInSamples; }
+  double getSampleRate() const { return header.sampleRate; }
+  juce::int64 getNumBuckets() const { return header.levelSize[0]; }
+
+  /** In-memory levels only: one level-0 bucket, summarised upwards by updateLevels() */
+  void setBucket(int channel, juce::int64 bucket, Bucket value) {
+    jassert(!storage.empty());
+    storage[(size_t)(bucket * header.numChannels + channel)] = value;
+  }
+
+  /** Recomputes every coarser bucket above level-0 buckets [first, last) */
+  void updateLevels(juce::int64 first, juce::int64 last) {
+    jassert(!storage.empty());
+    for (int level = 1; level < header.numLevels && first < last; ++level) {
+      first /= levelFactor;
+      last = (last + levelFactor - 1) / levelFactor;
+      for (auto b = first; b < last; ++b)
+        for (int ch = 0; ch < header.numChannels; ++ch) {
+          Accumulator merged;
+          accumulate(merged, ch, level - 1, b * levelFactor, (b + 1) * levelFactor);
+          storage[(size_t)((header.levelStart[level] + b) * header.numChannels + ch)] =
+              merged.toBucket();
+        }
+    }
+  }
+
+  /**
+   * Exact to the finest bucket: the coarsest buckets that fit inside the
+   * range, finer ones only at its edges, so any range costs at most
+   * 2 * levelFactor reads per level
+   */
+  Peak getPeak(int channel, juce::int64 start, juce::int64 end) const {
+    Accumulator result;
+    auto first = juce::jmax<juce::int64>(0, start) / samplesPerBucket;
+    auto last = (end + samplesPerBucket - 1) / samplesPerBucket;
+    for (int level = 0; first < last; ++level) {
+      if (level + 1 == header.numLevels) {
+        accumulate(result, channel, level, first, last);
+        break;
+      }
+      for (; first < last && first % levelFactor != 0; ++first)
+        accumulate(result, channel, level, first, first + 1);
+      for (; first < last && last % levelFactor != 0; --last)
+        accumulate(result, channel, level, last - 1, last);
+      first /= levelFactor;
+      last /= levelFactor;
+    }
+    return result.toPeak();
+  }
+
+  /** Coarsest level whose buckets are no wider than a pixel */
+  int chooseLevel(juce::int64 samplesPerPixel) const {
+    int level = 0;
+    while (level + 1 < header.numLevels && bucketWidth(level + 1) <= samplesPerPixel)
+      ++level;
+    return level;
+  }
+
+  /** The buckets of one level overlapping [start, end): cheap, rounded out to them */
+  Peak getLevelPeak(int channel, int level, juce::int64 start, juce::int64 end) const {
+    const auto width = bucketWidth(level);
+    Accumulator result;
+    accumulate(result, channel, level, start / width, (end + width - 1) / width);
+    return result.toPeak();
+  }
+
+private:
+  static constexpr int maxLevels = 24;
+
+  // Leads every stored file; data follows as [bucket][channel] per level
+  struct Header {
+    char magic[4] = { 'N', 'P', 'K', '1' }; // bump the digit when the layout changes
+    juce::int32 numChannels = 0;
+    juce::uint64 contentHash = 0;
+    juce::int64 lengthInSamples = 0;
+    double sampleRate = 0.0;
+    juce::int32 numLevels = 0;
+    juce::int32 reserved = 0;
+    juce::int64 levelStart[maxLevels] {}; // first bucket of each level
+    juce::int64 levelSize[maxLevels] {};  // buckets per channel in each level
+  };
+
+  // Level sizes and offsets for header.lengthInSamples
+  static void setLayout(Header &header) {
+    juce::int64 size = (header.lengthInSamples + samplesPerBucket - 1) / samplesPerBucket;
+    juce::int64 total = 0;
+    header.numLevels = 0;
+    for (;;) {
+      header.levelStart[header.numLevels] = total;
+      header.levelSize[header.numLevels] = size;
+      total += size;
+      if (++header.numLevels == maxLevels || size <= 1)
+        break;
+      size = (size + levelFactor - 1) / levelFactor;
+    }
+  }
+
+  struct Accumulator {
+    int min = 32767, max = -32767;
+    double sumSquares = 0.0;
+    juce::int64 samples = 0;
+
+    void add(const Bucket &bucket, juce::int64 length) {
+      min = juce::jmin(min, (int)bucket.min);
+      max = juce::jmax(max, (int)bucket.max);
+      sumSquares += (double)bucket.rms * bucket.rms * (double)length;
+      samples += length;
+    }
+
+    Bucket toBucket() const {
+      if (samples == 0)
+        return { 0, 0, 0 };
+      return { (juce::int16)min, (juce::int16)max,
+               (juce::int16)juce::roundToInt(std::sqrt(sumSquares / (double)samples)) };
+    }
+
+    Peak toPeak() const {
+      constexpr float toFloat = 1.0f / 32767.0f;
+      const auto bucket = toBucket();
+      return { bucket.min * toFloat, bucket.max * toFloat, bucket.rms * toFloat };
+    }
+  };
+
+  PeakLevels() = default;
+
+  static juce::int64 bucketWidth(int level) {
+    juce::int64 width = samplesPerBucket;
+    for (int i = 0; i < level; ++i)
+      width *= levelFactor;
+    return width;
+  }
+
+  // Source samples under bucket b; only the last bucket of a level is short
+  juce::int64 bucketLength(int level, juce::int64 b) const {
+    const auto width = bucketWidth(level);
+    return juce::jmin((b + 1) * width, header.lengthInSamples) - b * width;
+  }
+
+  size_t getNumStoredBuckets() const {
+    const auto last = header.numLevels - 1;
+    return (size_t)((header.levelStart[last] + header.levelSize[last]) * header.numChannels);
+  }
+
+  // Buckets [first, last) of one level, RMS weighted by the samples under each
+  void accumulate(Accumulator &result, int channel, int level, juce::int64 first,
+                  juce::int64 last) const {
+    first = juce::jmax<juce::int64>(0, first);
+    last = juce::jmin(last, header.levelSize[level]);
+    for (auto b = first; b < last; ++b)
+      result.add(buckets[(header.levelStart[level] + b) * header.numChannels + channel],
+                 bucketLength(level, b));
+  }
+
+  Header header;
+  const Bucket *buckets = nullptr;
+  std::vector<Bucket> storage;                        // built in memory
+  std::unique_ptr<juce::MemoryMappedFile> mappedFile; // or loaded with load()
+
+  JUCE_DECLARE_NON_COPYABLE(PeakLevels)
+};
+
+/**
+ * Waveform overview of an audio file with an on-disk cache. The PeakLevels
+ * are built on a background thread and stored in the cache directory under
+ * a hash of the file's content; reopening the same audio, even renamed or
+ * copied, memory-maps the stored levels instead of rescanning the file.
+ */
+class PeakPyramid {
+public:
+  using Peak = PeakLevels::Peak;
+
+  PeakPyramid(juce::AudioFormatManager &formats, const juce::File &cacheDirectory)
+      : formatManager(formats), cacheDir(cacheDirectory) {}
+
+  ~PeakPyramid() { pool.removeAllJobs(true, -1); }
+
+  /** Message thread: maps the cached levels for file, or starts building them */
+  void setSource(const juce::File &file) {
+    clear();
+    const auto hash = hashContent(file);
+    const auto cacheFile = getCacheFile(hash);
+    if (auto cached = PeakLevels::load(cacheFile, hash)) {
+      cacheFile.setLastModificationTime(juce::Time::getCurrentTime()); // most recently used
+      publish(std::move(cached));
+      return;
+    }
+    pool.addJob(new BuildJob(*this, file, hash), true);
+  }
+
+  /** Message thread: drops the current levels and stops any build */
+  void clear() {
+    pool.removeAllJobs(true, -1);
+    publish(nullptr);
+    buildProgress.store(0.0, std::memory_order_relaxed);
+  }
+
+  bool isReady() const { return getLevels() != nullptr; }
+  bool isBuilding() const { return pool.getNumJobs() > 0; }
+  double getBuildProgress() const { return buildProgress.load(std::memory_order_relaxed); }
+
+  int getNumChannels() const {
+    auto levels = getLevels();
+    return levels != nullptr ? levels->getNumChannels() : 0;
+  }
+  juce::int64 getLengthInSamples() const {
+    auto levels = getLevels();
+    return levels != nullptr ? levels->getLengthInSamples() : 0;
+  }
+  double getSampleRate() const {
+    auto levels = getLevels();
+    return levels != nullptr ? levels->getSampleRate() : 0.0;
+  }
+
+  /** Min, max and RMS of channel over source samples [start, end) */
+  Peak getPeak(int channel, juce::int64 start, juce::int64 end) const {
+    auto levels = getLevels();
+    if (levels == nullptr || channel >= levels->getNumChannels())
+      return {};
+    return levels->getPeak(channel, start, end);
+  }
+
+  /**
+   * One column per pixel over source samples [start, end), channels stacked:
+   * min-max in peakColour with the RMS band over it in rmsColour. Costs a
+   * few bucket reads per pixel at any zoom.
+   */
+  void drawChannels(juce::Graphics &g, juce::Rectangle<int> area, juce::int64 start,
+                    juce::int64 end, juce::Colour peakColour, juce::Colour rmsColour) const {
+    auto levels = getLevels();
+    if (levels == nullptr || area.isEmpty() || end <= start)
+      return;
+
+    const int numChannels = levels->getNumChannels();
+    const int width = area.getWidth();
+    const float rowHeight = (float)area.getHeight() / (float)numChannels;
+    const int level = levels->chooseLevel((end - start) / width);
+    const double samplesPerPixel = (double)(end - start) / (double)width;
+
+    juce::RectangleList<float> peaks, bands;
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const float centre = (float)area.getY() + rowHeight * ((float)ch + 0.5f);
+      const float scale = rowHeight * 0.5f;
+      for (int x = 0; x < width; ++x) {
+        const auto from = start + (juce::int64)(samplesPerPixel * x);
+        const auto to = juce::jmax(from + 1, start + (juce::int64)(samplesPerPixel * (x + 1)));
+        const auto peak = levels->getLevelPeak(ch, level, from, to);
+        const float left = (float)(area.getX() + x);
+        peaks.addWithoutMerging({ left, centre - peak.max * scale, 1.0f,
+                                  juce::jmax(1.0f, (peak.max - peak.min) * scale) });
+        bands.addWithoutMerging({ left, centre - peak.rms * scale, 1.0f, peak.rms * 2.0f * scale });
+      }
+    }
+
+    g.setColour(peakColour);
+    g.fillRectList(peaks);
+    g.setColour(rmsColour);
+    g.fillRectList(bands);
+  }
+
+private:
+  static constexpr int maxCacheFiles = 64;
+  static constexpr int hashBlockBytes = 64 * 1024;
+
+  class BuildJob : public juce::ThreadPoolJob {
+  public:
+    BuildJob(PeakPyramid &ownerRef, const juce::File &fileToScan, juce::uint64 hash)
+        : juce::ThreadPoolJob("Peaks " + fileToScan.getFileName()), owner(ownerRef),
+          file(fileToScan), contentHash(hash) {}
+
+    JobStatus runJob() override {
+      if (auto levels = build()) {
+        // Serve them from the cache file when that can be written
+        const auto cacheFile = owner.getCacheFile(contentHash);
+        if (levels->store(cacheFile)) {
+          if (auto mapped = PeakLevels::load(cacheFile, contentHash))
+            levels = std::move(mapped);
+          owner.pruneCache();
+        }
+        if (!shouldExit())
+          owner.publish(std::move(levels));
+      }
+      return jobHasFinished;
+    }
+
+  private:
+    std::unique_ptr<PeakLevels> build() {
+      std::unique_ptr<juce::AudioFormatReader> reader(owner.formatManager.createReaderFor(file));
+      if (reader == nullptr || reader->lengthInSamples <= 0 || reader->numChannels == 0)
+        return nullptr;
+
+      const int numChannels = (int)reader->numChannels;
+      const auto length = reader->lengthInSamples;
+      auto levels = std::make_unique<PeakLevels>(length, numChannels, reader->sampleRate,
+                                                 contentHash);
+      constexpr int samplesPerBucket = PeakLevels::samplesPerBucket;
+
+      // Level 0 from the audio, in chunks of whole buckets
+      constexpr int chunkBuckets = 256;
+      juce::AudioBuffer<float> chunk(numChannels, chunkBuckets * samplesPerBucket);
+      for (juce::int64 bucket = 0; bucket < levels->getNumBuckets(); bucket += chunkBuckets) {
+        if (shouldExit())
+          return nullptr;
+        const auto position = bucket * samplesPerBucket;
+        const int numSamples =
+            (int)juce::jmin<juce::int64>(chunk.getNumSamples(), length - position);
+        if (!reader->read(&chunk, 0, numSamples, position, true, true))
+          return nullptr;
+
+        for (int offset = 0, b = 0; offset < numSamples; offset += samplesPerBucket, ++b)
+          for (int ch = 0; ch < numChannels; ++ch)
+            levels->setBucket(ch, bucket + b,
+                              PeakLevels::Bucket::fromSamples(
+                                  chunk.getReadPointer(ch, offset),
+                                  juce::jmin(samplesPerBucket, numSamples - offset)));
+        owner.buildProgress.store((double)(bucket + chunkBuckets) / (double)levels->getNumBuckets(),
+                                  std::memory_order_relaxed);
+      }
+
+      levels->updateLevels(0, levels->getNumBuckets());
+      return levels;
+    }
+
+    PeakPyramid &owner;
+    const juce::File file;
+    const juce::uint64 contentHash;
+  };
+
+  /**
+   * FNV-1a over the file size, modification time and 64 KB from its start,
+   * middle and end: the same cost for any length, it follows the file when
+   * renamed or moved, and any edit (which updates the time) misses
+   */
+  static juce::uint64 hashContent(const juce::File &file) {
+    juce::uint64 hash = 14695981039346656037ull;
+    auto mix = [&hash](const void *data, size_t size) {
+      for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<const juce::uint8 *>(data)[i];
+        hash *= 1099511628211ull;
+      }
+    };
+
+    const auto size = file.getSize();
+    const auto modified = file.getLastModificationTime().toMilliseconds();
+    mix(&size, sizeof(size));
+    mix(&modified, sizeof(modified));
+    juce::FileInputStream stream(file);
+    if (stream.openedOk()) {
+      std::vector<char> block((size_t)hashBlockBytes);
+      for (auto position : { (juce::int64)0, size / 2, size - hashBlockBytes }) {
+        stream.setPosition(juce::jmax<juce::int64>(0, position));
+        const int read = stream.read(block.data(), hashBlockBytes);
+        mix(block.data(), (size_t)juce::jmax(0, read));
+      }
+    }
+    return hash;
+  }
+
+  juce::File getCacheFile(juce::uint64 hash) const {
+    return cacheDir.getChildFile(juce::String::toHexString((juce::int64)hash) + ".peaks");
+  }
+
+  // Keeps the maxCacheFiles most recently used pyramids
+  void pruneCache() const {
+    auto files = cacheDir.findChildFiles(juce::File::findFiles, false, "*.peaks");
+    if (files.size() <= maxCacheFiles)
+      return;
+    std::sort(files.begin(), files.end(), [](const juce::File &a, const juce::File &b) {
+      return a.getLastModificationTime() > b.getLastModificationTime();
+    });
+    for (int i = maxCacheFiles; i < files.size(); ++i)
+      files.getReference(i).deleteFile();
+  }
+
+  void publish(std::shared_ptr<const PeakLevels> levels) {
+    const juce::ScopedLock sl(levelsLock);
+    current = std::move(levels);
+  }
+
+  std::shared_ptr<const PeakLevels> getLevels() const {
+    const juce::ScopedLock sl(levelsLock);
+    return current;
+  }
+
+  juce::AudioFormatManager &formatManager;
+  const juce::File cacheDir;
+  juce::ThreadPool pool { 1 };
+  std::atomic<double> buildProgress { 0.0 };
+
+  juce::CriticalSection levelsLock;
+  std::shared_ptr<const PeakLevels> current;
+
+  JUCE_DECLARE_NON_COPYABLE(PeakPyramid)
+};
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "../Render/OfflineRenderer.h"
+#include "PeakPyramid.h"
+
+/**
+ * Peaks of the loaded file as the current settings process it, for drawing
+ * over the input waveform. A low-priority thread renders the file through
+ * its own engine and fills the PeakLevels block by block, starting at the
+ * focus (the start of the visible range) and wrapping round to the top of
+ * the file. A change of sound restarts it at the focus, keeping the reader
+ * and the peak storage.
+ */
+class ProcessedWaveform : private juce::Thread {
+public:
+  explicit ProcessedWaveform(juce::AudioFormatManager &formats)
+      : juce::Thread("Processed waveform"), formatManager(formats) {}
+
+  ~ProcessedWaveform() override { stopThread(-1); }
+
+  /** Message thread: renders file from now on; File() stops */
+  void setSource(const juce::File &file) {
+    {
+      const juce::ScopedLock sl(requestLock);
+      requestedFile = file;
+    }
+    restart();
+  }
+
+  /** Message thread: restarts the render if these settings sound different */
+  void setSettings(const RenderSettings &settings) {
+    {
+      const juce::ScopedLock sl(requestLock);
+      if (settings.soundsSameAs(requestedSettings))
+        return;
+      requestedSettings = settings;
+    }
+    restart();
+  }
+
+  /** Where the next restart begins rendering, in source samples */
+  void setFocus(juce::int64 sample) { focus.store(sample, std::memory_order_relaxed); }
+
+  /** Fraction of the file rendered with the current settings */
+  double getProgress() const { return progress.load(std::memory_order_relaxed); }
+
+  /**
+   * Processed min-max over source samples [start, end) in peakColour, one
+   * column per pixel and channels stacked as PeakPyramid draws them. Columns
+   * peaking above hotLevel, where the shaper and the soft limit flatten the
+   * output, are drawn in hotColour. Columns not rendered yet are left out.
+   */
+  void drawChannels(juce::Graphics &g, juce::Rectangle<int> area, juce::int64 start,
+                    juce::int64 end, juce::Colour peakColour, juce::Colour hotColour) const {
+    const juce::ScopedLock sl(levelsLock);
+    if (levels == nullptr || area.isEmpty() || end <= start)
+      return;
+
+    const int numChannels = levels->getNumChannels();
+    const int width = area.getWidth();
+    const float rowHeight = (float)area.getHeight() / (float)numChannels;
+    const double samplesPerPixel = (double)(end - start) / (double)width;
+
+    juce::RectangleList<float> peaks, hot;
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const float centre = (float)area.getY() + rowHeight * ((float)ch + 0.5f);
+      const float scale = rowHeight * 0.5f;
+      for (int x = 0; x < width; ++x) {
+        const auto from = start + (juce::int64)(samplesPerPixel * x);
+        const auto to = juce::jmax(from + 1, start + (juce::int64)(samplesPerPixel * (x + 1)));
+
+        // Only the rendered part of the column, from either pass
+        bool any = false;
+        PeakLevels::Peak peak { 1.0f, -1.0f, 0.0f };
+        for (const auto &rendered : { renderedFromFocus, renderedToFocus }) {
+          const auto part = rendered.getIntersectionWith({ from, to });
+          if (part.isEmpty())
+            continue;
+          const auto partPeak = levels->getPeak(ch, part.getStart(), part.getEnd());
+          peak.min = juce::jmin(peak.min, partPeak.min);
+          peak.max = juce::jmax(peak.max, partPeak.max);
+          any = true;
+        }
+        if (!any)
+          continue;
+
+        const juce::Rectangle<float> column { (float)(area.getX() + x), centre - peak.max * scale,
+                                              1.0f, juce::jmax(1.0f, (peak.max - peak.min) * scale) };
+        if (juce::jmax(peak.max, -peak.min) > hotLevel)
+          hot.addWithoutMerging(column);
+        else
+          peaks.addWithoutMerging(column);
+      }
+    }
+
+    g.setColour(peakColour);
+    g.fillRectList(peaks);
+    g.setColour(hotColour);
+    g.fillRectList(hot);
+  }
+
+private:
+  static constexpr float hotLevel = 0.891f; // -1 dBFS
+  static constexpr int blockSize = 4096;
+
+  void restart() {
+    ++requestGeneration;
+    progress.store(0.0, std::memory_order_relaxed);
+    if (!isThreadRunning())
+      startThread(juce::Thread::Priority::low);
+    notify();
+  }
+
+  void run() override {
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::File readerFile;
+
+    while (!threadShouldExit()) {
+      const int generation = requestGeneration.load();
+      juce::File file;
+      RenderSettings settings;
+      {
+        const juce::ScopedLock sl(requestLock);
+        file = requestedFile;
+        settings = requestedSettings;
+      }
+
+      // A new file gets new storage; new settings reuse it
+      if (file != readerFile) {
+        readerFile = file;
+        reader.reset(file == juce::File() ? nullptr : formatManager.createReaderFor(file));
+        std::unique_ptr<PeakLevels> newLevels;
+        if (reader != nullptr && reader->lengthInSamples > 0 && reader->numChannels > 0)
+          newLevels = std::make_unique<PeakLevels>(reader->lengthInSamples,
+                                                   (int)reader->numChannels, reader->sampleRate);
+        const juce::ScopedLock sl(levelsLock);
+        levels = std::move(newLevels);
+        renderedFromFocus = renderedToFocus = {};
+      }
+
+      if (levels != nullptr)
+        render(*reader, settings, generation);
+
+      // Sleep until the next request unless one came in meanwhile
+      if (generation == requestGeneration.load())
+        wait(-1);
+    }
+  }
+
+  void render(juce::AudioFormatReader &reader, RenderSettings settings, int generation) {
+    // The float engine: a preview needs no double-precision reference
+    settings.doublePrecision = false;
+    settings.blockSize = blockSize;
+    const auto length = levels->getLengthInSamples();
+    const auto focusStart = juce::jlimit<juce::int64>(0, length, focus.load()) /
+                            PeakLevels::samplesPerBucket * PeakLevels::samplesPerBucket;
+    {
+      const juce::ScopedLock sl(levelsLock);
+      renderedFromFocus = { focusStart, focusStart };
+      renderedToFocus = {};
+    }
+    progress.store(0.0, std::memory_order_relaxed);
+
+    if (renderRange(reader, settings, focusStart, length, renderedFromFocus, generation))
+      renderRange(reader, settings, 0, focusStart, renderedToFocus, generation);
+  }
+
+  /**
+   * Processes [start, end) after a pre-roll (as SegmentedRenderer does) and
+   * publishes each block's finished buckets, aligned for the engine latency.
+   * False once a newer request or thread exit interrupts it.
+   */
+  bool renderRange(juce::AudioFormatReader &reader, const RenderSettings &settings,
+                   juce::int64 start, juce::int64 end, juce::Range<juce::int64> &rendered,
+                   int generation) {
+    if (start >= end)
+      return true;
+
+    constexpr int samplesPerBucket = PeakLevels::samplesPerBucket;
+    const int numChannels = levels->getNumChannels();
+    const double sampleRate = levels->getSampleRate();
+    const auto length = levels->getLengthInSamples();
+    RenderChain chain(sampleRate, numChannels, settings);
+
+    const auto preRoll = (juce::int64)(juce::jmax(0.0, settings.preRollSeconds) * sampleRate);
+    auto inputPos = juce::jmax<juce::int64>(0, start - preRoll);
+    auto outputPos = inputPos - chain.getLatencySamples(); // source sample of the next output
+    auto bucketPos = start;                                // next source sample to summarise
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    juce::AudioBuffer<float> staging(numChannels, samplesPerBucket);
+    int staged = 0;
+    std::vector<PeakLevels::Bucket> finished; // [bucket][channel]
+
+    while (bucketPos < end) {
+      if (threadShouldExit() || generation != requestGeneration.load())
+        return false;
+
+      // Reads past the end are silence, which flushes the latency
+      if (!reader.read(&block, 0, blockSize, inputPos, true, numChannels > 1))
+        return false;
+      chain.process(block);
+      inputPos += blockSize;
+
+      const auto firstBucket = bucketPos / samplesPerBucket;
+      for (int i = (int)juce::jlimit<juce::int64>(0, blockSize, bucketPos - outputPos);
+           i < blockSize && bucketPos < end;) {
+        const int take = (int)juce::jmin<juce::int64>(blockSize - i, samplesPerBucket - staged,
+                                                      end - bucketPos);
+        for (int ch = 0; ch < numChannels; ++ch)
+          staging.copyFrom(ch, staged, block, ch, i, take);
+        staged += take;
+        i += take;
+        bucketPos += take;
+        if (staged == samplesPerBucket || bucketPos == end) {
+          for (int ch = 0; ch < numChannels; ++ch)
+            finished.push_back(PeakLevels::Bucket::fromSamples(staging.getReadPointer(ch), staged));
+          staged = 0;
+        }
+      }
+      outputPos += blockSize;
+
+      if (!finished.empty()) {
+        const auto count = (juce::int64)finished.size() / numChannels;
+        const juce::ScopedLock sl(levelsLock);
+        for (juce::int64 b = 0; b < count; ++b)
+          for (int ch = 0; ch < numChannels; ++ch)
+            levels->setBucket(ch, firstBucket + b, finished[(size_t)(b * numChannels + ch)]);
+        levels->updateLevels(firstBucket, firstBucket + count);
+        rendered.setEnd(juce::jmin(length, (firstBucket + count) * samplesPerBucket));
+        finished.clear();
+        progress.store((double)(renderedFromFocus.getLength() + renderedToFocus.getLength()) /
+                           (double)length,
+                       std::memory_order_relaxed);
+      }
+    }
+    return true;
+  }
+
+  juce::AudioFormatManager &formatManager;
+
+  // Requests from the message thread; each one bumps requestGeneration
+  juce::CriticalSection requestLock;
+  juce::File requestedFile;
+  RenderSettings requestedSettings;
+  std::atomic<int> requestGeneration { 0 };
+  std::atomic<juce::int64> focus { 0 };
+  std::atomic<double> progress { 0.0 };
+
+  // Written by the render thread in short locked steps, drawn under the lock
+  juce::CriticalSection levelsLock;
+  std::unique_ptr<PeakLevels> levels;
+  juce::Range<juce::int64> renderedFromFocus, renderedToFocus;
+
+  JUCE_DECLARE_NON_COPYABLE(ProcessedWaveform)
+};